@@ -0,0 +1,173 @@
+// Drives the planner in closed loop on the synthetic scene: the traffic keeps
+// its lane and speed, slowing to the ego's speed when it comes up behind it
+// (traffic in the simulator does not run into the ego car either), the ego
+// car drives the first points of every path sent,
+// like the simulator does between two telemetry frames, and the next frame
+// is built from there. Reports how the car drove, and with record_file writes
+// every frame in the format of `path_planning --record` for replay_bench.
+// The planner runs inline with a large budget, so a run is repeatable.
+//
+//   closed_loop_bench [map_file] [frames] [record_file]
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "kinematic_validator.h"
+#include "planner.h"
+#include "synthetic_scene.h"
+#include "telemetry_log.h"
+#include "waypoint_map.h"
+
+using namespace std;
+
+// points driven between two frames
+static const int kDriven = 3;
+static const double kDt = 0.02;
+// traffic closer than this behind the ego car in its lane follows it
+static const double kFollowGap = 15.0;
+
+int main(int argc, char **argv)
+{
+	string map_file = argc > 1 ? argv[1] : "../data/highway_map.csv";
+	int frames = argc > 2 ? atoi(argv[2]) : 3000;
+
+	shared_ptr<const WaypointMap> map = WaypointMap::fromFile(map_file, 6945.554);
+	if (map->size() < 3)
+	{
+		cerr << "Failed to load map from " << map_file << endl;
+		return -1;
+	}
+	TelemetryRecorder recorder;
+	if (argc > 3 && !recorder.open(argv[3]))
+	{
+		cerr << "Failed to open " << argv[3] << endl;
+		return -1;
+	}
+
+	// traffic as s, d, speed and the speed it keeps when free; the ego starts
+	// from standstill
+	Telemetry telemetry = syntheticTelemetry(*map);
+	vector<array<double, 4>> cars;
+	for (const vector<double> &car : telemetry.sensor_fusion)
+	{
+		double speed = hypot(car[3], car[4]);
+		cars.push_back({car[5], car[6], speed, speed});
+	}
+	telemetry.previous_path_x.clear();
+	telemetry.previous_path_y.clear();
+	telemetry.end_path_s = 0.0;
+	telemetry.end_path_d = 0.0;
+	telemetry.car_speed = 0.0;
+
+	Planner planner(0, 1000.0);
+	TrajectoryBuffer trajectory;
+	vector<double> next_x_vals;
+	vector<double> next_y_vals;
+	vector<double> driven_x = {telemetry.car_x};
+	vector<double> driven_y = {telemetry.car_y};
+	int lane = (int)(telemetry.car_d / 4.0);
+	int lane_changes = 0;
+	int collision_frames = 0;
+	double min_gap = 1e9;
+
+	streambuf *out = cout.rdbuf(nullptr);
+	for (int frame = 0; frame < frames; frame++)
+	{
+		telemetry.sensor_fusion.clear();
+		double ego_v = telemetry.car_speed * 0.44704;
+		for (size_t i = 0; i < cars.size(); i++)
+		{
+			double behind = telemetry.car_s - cars[i][0];
+			bool following = fabs(cars[i][1] - telemetry.car_d) < 2.0 && behind > 0.0 && behind < kFollowGap;
+			cars[i][2] = following ? min(cars[i][3], ego_v) : cars[i][3];
+			vector<double> p = map->getXY(cars[i][0], cars[i][1]);
+			vector<double> q = map->getXY(cars[i][0] + 1.0, cars[i][1]);
+			double heading = atan2(q[1] - p[1], q[0] - p[0]);
+			telemetry.sensor_fusion.push_back(
+				{(double)i, p[0], p[1], cars[i][2] * cos(heading), cars[i][2] * sin(heading), cars[i][0], cars[i][1]});
+		}
+		if (recorder.isOpen())
+		{
+			recorder.record(telemetryJson(telemetry));
+		}
+		planner.plan(telemetry, *map, trajectory, next_x_vals, next_y_vals);
+
+		int driven = min((int)next_x_vals.size(), kDriven);
+		driven_x.insert(driven_x.end(), next_x_vals.begin(), next_x_vals.begin() + driven);
+		driven_y.insert(driven_y.end(), next_y_vals.begin(), next_y_vals.begin() + driven);
+		size_t n = driven_x.size();
+		double dx = driven_x[n - 1] - driven_x[n - 2];
+		double dy = driven_y[n - 1] - driven_y[n - 2];
+		double yaw = atan2(dy, dx);
+		vector<double> frenet = map->getFrenet(driven_x[n - 1], driven_y[n - 1], yaw);
+		telemetry.car_x = driven_x[n - 1];
+		telemetry.car_y = driven_y[n - 1];
+		telemetry.car_s = frenet[0];
+		telemetry.car_d = frenet[1];
+		telemetry.car_yaw = yaw * 180 / M_PI;
+		telemetry.car_speed = hypot(dx, dy) / kDt / 0.44704;
+		telemetry.previous_path_x.assign(next_x_vals.begin() + driven, next_x_vals.end());
+		telemetry.previous_path_y.assign(next_y_vals.begin() + driven, next_y_vals.end());
+		for (array<double, 4> &car : cars)
+		{
+			car[0] += car[2] * kDt * driven;
+		}
+
+		if ((int)(telemetry.car_d / 4.0) != lane)
+		{
+			lane = (int)(telemetry.car_d / 4.0);
+			lane_changes++;
+		}
+		// cars 5 m long and 2 m wide, centred on their s and d
+		bool overlap = false;
+		for (const array<double, 4> &car : cars)
+		{
+			double gap = car[0] - telemetry.car_s;
+			double offset = fabs(car[1] - telemetry.car_d);
+			overlap = overlap || (fabs(gap) < 5.0 && offset < 2.0);
+			if (offset < 2.0 && gap >= 0.0)
+			{
+				min_gap = min(min_gap, gap);
+			}
+		}
+		collision_frames += overlap;
+	}
+	cout.rdbuf(out);
+
+	double distance = 0.0;
+	for (size_t i = 1; i < driven_x.size(); i++)
+	{
+		distance += hypot(driven_x[i] - driven_x[i - 1], driven_y[i] - driven_y[i - 1]);
+	}
+	// the simulator's windowed acceleration and jerk over the driven path
+	KinematicValidator validator;
+	double a_max = 0.0;
+	double jerk_max = 0.0;
+	int violations = 0;
+	int window = KinematicValidator::kMaxPoints;
+	for (size_t start = 0; start + window <= driven_x.size(); start += window - validator.limits().window)
+	{
+		KinematicReport report;
+		validator.validate(&driven_x[start], &driven_y[start], window, report);
+		a_max = max(a_max, report.a_max);
+		jerk_max = max(jerk_max, report.jerk_max);
+		violations += report.acceleration_violations + report.jerk_violations;
+	}
+	const PlannerStats &stats = planner.stats();
+
+	cout << fixed << setprecision(2);
+	cout << frames << " frames, " << distance << " m at " << distance / ((driven_x.size() - 1) * kDt) << " m/s" << endl;
+	cout << "lane changes            " << lane_changes << endl;
+	cout << "collision frames        " << collision_frames << endl;
+	cout << "closest gap ahead       " << min_gap << " m" << endl;
+	cout << "max acceleration, jerk  " << a_max << " m/s^2, " << jerk_max << " m/s^3 (" << violations
+		 << " samples beyond the limits)" << endl;
+	cout << "spline fits reused      " << stats.spline_fits_reused << " of " << stats.spline_fits << endl;
+	cout << "candidates rejected     " << stats.candidates_rejected << ", frames sent beyond the limits "
+		 << stats.kinematic_violations << endl;
+	return 0;
+}
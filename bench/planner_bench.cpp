@@ -0,0 +1,119 @@
+// Times Planner::plan on a synthetic frame for 0..hardware_concurrency workers.
+// Built with COUNT_ALLOCATIONS it also reports the heap allocations per frame
+// once the planner's buffers have grown, which should be none, and those of
+// the whole message path of the server: the JSON DOM of the telemetry
+// message, parsing it into reused buffers, planning and building the reply.
+//
+//   planner_bench [map_file] [frames] [max_threads]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "json.hpp"
+#include "planner.h"
+#include "synthetic_scene.h"
+#include "telemetry_log.h"
+#include "waypoint_map.h"
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+	string map_file = argc > 1 ? argv[1] : "../data/highway_map.csv";
+	int frames = argc > 2 ? atoi(argv[2]) : 200;
+
+	shared_ptr<const WaypointMap> map = WaypointMap::fromFile(map_file, 6945.554);
+	if (map->size() < 3)
+	{
+		cerr << "Failed to load map from " << map_file << endl;
+		return -1;
+	}
+	Telemetry telemetry = syntheticTelemetry(*map);
+
+	int max_threads = argc > 3 ? atoi(argv[3]) : max(1u, thread::hardware_concurrency());
+	double baseline = 0.0;
+	cout << "threads  candidates  us/frame  speedup  deadline hits  allocs/frame" << endl;
+	for (int threads = 0; threads < max_threads; threads++)
+	{
+		// large budget so every candidate is evaluated in every frame
+		Planner planner(threads, 1000.0);
+		TrajectoryBuffer trajectory;
+		vector<double> next_x_vals;
+		vector<double> next_y_vals;
+
+		// the planner logs every frame; the behaviour layer alternates
+		// between two candidate sets here, warm up on both
+		streambuf *out = cout.rdbuf(nullptr);
+		for (int i = 0; i < 4; i++)
+		{
+			planner.plan(telemetry, *map, trajectory, next_x_vals, next_y_vals);
+		}
+		unsigned long allocations = allocation_counter::count();
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int i = 0; i < frames; i++)
+		{
+			planner.plan(telemetry, *map, trajectory, next_x_vals, next_y_vals);
+		}
+		double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / frames;
+		allocations = allocation_counter::count() - allocations;
+		cout.rdbuf(out);
+
+		if (threads == 0)
+		{
+			baseline = us;
+		}
+		cout << setw(7) << threads + 1 << setw(12) << planner.numCandidates()
+			 << setw(10) << fixed << setprecision(1) << us
+			 << setw(9) << setprecision(2) << baseline / us
+			 << setw(15) << planner.stats().deadline_hits;
+		if (allocation_counter::enabled())
+		{
+			cout << setw(14) << setprecision(1) << (double)allocations / frames;
+		}
+		else
+		{
+			cout << setw(14) << "-";
+		}
+		cout << endl;
+	}
+
+	if (allocation_counter::enabled())
+	{
+		// what the server's onMessage does with the same frame
+		string payload = "[\"telemetry\"," + telemetryJson(telemetry).dump() + "]";
+		Planner planner(0, 1000.0);
+		TrajectoryBuffer trajectory;
+		Telemetry received;
+		vector<double> next_x_vals;
+		vector<double> next_y_vals;
+		string msg;
+		unsigned long dom = 0;
+		unsigned long rest = 0;
+		streambuf *out = cout.rdbuf(nullptr);
+		for (int i = -4; i < frames; i++)
+		{
+			unsigned long allocations = allocation_counter::count();
+			nlohmann::json j = nlohmann::json::parse(payload);
+			unsigned long parsed = allocation_counter::count();
+			parseTelemetry(j[1], received);
+			planner.plan(received, *map, trajectory, next_x_vals, next_y_vals);
+			controlMessage(next_x_vals, next_y_vals, msg);
+			// warm-up frames are not counted
+			if (i >= 0)
+			{
+				dom += parsed - allocations;
+				rest += allocation_counter::count() - parsed;
+			}
+		}
+		cout.rdbuf(out);
+		cout << "message path allocs/frame: " << setprecision(1) << (double)dom / frames << " JSON DOM, "
+			 << (double)rest / frames << " parsing into buffers, planning and reply" << endl;
+	}
+	return 0;
+}
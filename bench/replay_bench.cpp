@@ -0,0 +1,101 @@
+// Replays a session recorded with `path_planning --record <file>` through the
+// planner, bound once to the compile-time StaticPlannerParams and once to
+// runtime PlannerParams (the defaults, or read from params_file), and times
+// both. With the defaults both have to send the same paths.
+//
+//   replay_bench <session> [map_file] [runs] [params_file]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "planner.h"
+#include "telemetry_log.h"
+#include "waypoint_map.h"
+
+using namespace std;
+
+// plans every frame in order, returns us per frame; paths gets the path sent
+// in every frame
+static double replay(const vector<Telemetry> &frames, const WaypointMap &map, const PlannerParams *params,
+					 vector<vector<double>> &paths)
+{
+	// inline and with a large budget, so every candidate of every frame is
+	// evaluated and both bindings do the same work
+	Planner planner(0, 1000.0);
+	if (params)
+	{
+		planner.setParams(*params);
+	}
+	TrajectoryBuffer trajectory;
+	vector<double> next_x_vals;
+	vector<double> next_y_vals;
+	paths.resize(frames.size());
+
+	streambuf *out = cout.rdbuf(nullptr);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		planner.plan(frames[i], map, trajectory, next_x_vals, next_y_vals);
+		paths[i] = next_x_vals;
+		paths[i].insert(paths[i].end(), next_y_vals.begin(), next_y_vals.end());
+	}
+	double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / frames.size();
+	cout.rdbuf(out);
+	return us;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		cerr << "Usage: " << argv[0] << " <session> [map_file] [runs] [params_file]" << endl;
+		return -1;
+	}
+	string map_file = argc > 2 ? argv[2] : "../data/highway_map.csv";
+	int runs = argc > 3 ? max(1, atoi(argv[3])) : 5;
+
+	vector<Telemetry> frames;
+	if (!loadTelemetryLog(argv[1], frames) || frames.empty())
+	{
+		cerr << "No frames in " << argv[1] << endl;
+		return -1;
+	}
+	shared_ptr<const WaypointMap> map = WaypointMap::fromFile(map_file, 6945.554);
+	if (map->size() < 3)
+	{
+		cerr << "Failed to load map from " << map_file << endl;
+		return -1;
+	}
+	PlannerParams params;
+	if (argc > 4 && !PlannerParams::fromFile(argv[4], params))
+	{
+		return -1;
+	}
+
+	// alternating runs, the fastest of each counts
+	double static_us = 1e30;
+	double runtime_us = 1e30;
+	vector<vector<double>> static_paths;
+	vector<vector<double>> runtime_paths;
+	for (int run = 0; run < runs; run++)
+	{
+		static_us = min(static_us, replay(frames, *map, nullptr, static_paths));
+		runtime_us = min(runtime_us, replay(frames, *map, &params, runtime_paths));
+	}
+	int different = 0;
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		different += static_paths[i] != runtime_paths[i];
+	}
+
+	cout << frames.size() << " frames, fastest of " << runs << " runs" << endl;
+	cout << "params    us/frame" << endl;
+	cout << "static  " << setw(10) << fixed << setprecision(1) << static_us << endl;
+	cout << "runtime " << setw(10) << runtime_us << "  (" << setprecision(2) << runtime_us / static_us << "x)" << endl;
+	cout << "frames with different paths: " << different << endl;
+	return 0;
+}
@@ -0,0 +1,116 @@
+// Fits the planner's five-anchor splines (two stitched points, three lane
+// anchors) with the anchors drifting a little from fit to fit, once with a
+// fresh decomposition per fit and once through a spline_factorization, and
+// reports fits per second, how far the cached splines stray, and the largest
+// jump of their first and second derivative at a knot. Exits with 1 if a
+// cached fit kinks by more than the factorization's max_jump.
+//
+//   spline_fit_bench [fits]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "spline.h"
+
+using namespace std;
+
+// anchors in the car's local frame, k-th fit of a slowly changing scene
+static void anchors(int k, vector<double> &x, vector<double> &y)
+{
+	double step = 0.4 + 0.05 * sin(k * 0.01);
+	double ahead = 26.0 + 2.0 * sin(k * 0.003);
+	double bend = 0.5 * sin(k * 0.002);
+	double x_vals[] = {-step, 0.0, ahead, ahead + 15.0, ahead + 60.0};
+	double y_vals[] = {0.0, 0.0, bend, 2.0 * bend + 0.5 * sin(k * 0.02), 4.0 * bend};
+	x.assign(x_vals, x_vals + 5);
+	y.assign(y_vals, y_vals + 5);
+}
+
+// largest difference of the order-th derivative across an inner knot, knot 1
+// is where a new path is stitched onto the kept one
+static double knotJump(const tk::spline &sp, const vector<double> &x, int order)
+{
+	double jump = 0.0;
+	for (size_t i = 1; i + 1 < x.size(); i++)
+	{
+		// at x[i] itself the piece left of the knot is evaluated
+		double left = sp.deriv(order, x[i]);
+		double right = sp.deriv(order, nextafter(x[i], x[i + 1]));
+		jump = max(jump, fabs(right - left));
+	}
+	return jump;
+}
+
+int main(int argc, char **argv)
+{
+	int fits = argc > 1 ? atoi(argv[1]) : 200000;
+	vector<double> x;
+	vector<double> y;
+	double checksum = 0.0;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int k = 0; k < fits; k++)
+	{
+		anchors(k, x, y);
+		tk::spline sp;
+		sp.set_points(x, y);
+		checksum += sp(10.0);
+	}
+	double fresh = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "tolerance  fits/s  speedup  reused  max deviation [m]  max f' jump  max f'' jump" << endl;
+	cout << setw(9) << "-" << setw(8) << fixed << setprecision(0) << fits / fresh << setw(9) << "1.00"
+		 << setw(8) << "-" << setw(19) << "-" << setw(13) << "-" << setw(14) << "-" << endl;
+	bool kinked = false;
+	for (double tolerance : {0.0, 0.01, 0.05, 0.2})
+	{
+		tk::spline_factorization cache(tolerance);
+		start = chrono::steady_clock::now();
+		for (int k = 0; k < fits; k++)
+		{
+			anchors(k, x, y);
+			tk::spline sp;
+			sp.set_points(x, y, cache);
+			checksum += sp(10.0);
+		}
+		double cached = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		// deviation from the exact fit along the sampled part of the path
+		double deviation = 0.0;
+		double jump1 = 0.0;
+		double jump2 = 0.0;
+		tk::spline_factorization check(tolerance);
+		for (int k = 0; k < fits; k += 97)
+		{
+			anchors(k, x, y);
+			tk::spline exact;
+			exact.set_points(x, y);
+			tk::spline sp;
+			sp.set_points(x, y, check);
+			for (double u = 0.0; u <= 40.0; u += 0.5)
+			{
+				deviation = max(deviation, fabs(sp(u) - exact(u)));
+			}
+			jump1 = max(jump1, knotJump(sp, x, 1));
+			jump2 = max(jump2, knotJump(sp, x, 2));
+		}
+		// the rounding of evaluating both pieces at the knot on top
+		kinked = kinked || jump1 > check.maxJump() + 1e-12;
+
+		cout << setw(9) << setprecision(2) << tolerance << setw(8) << setprecision(0) << fits / cached
+			 << setw(9) << setprecision(2) << fresh / cached << setw(7) << setprecision(0)
+			 << 100.0 * cache.hits() / fits << "%" << setw(19) << setprecision(4) << deviation
+			 << setw(13) << scientific << setprecision(1) << jump1 << setw(14) << jump2 << fixed << endl;
+	}
+	cout << "(" << setprecision(1) << checksum << ")" << endl;
+	if (kinked)
+	{
+		cout << "cached fits exceed the first derivative jump they allow" << endl;
+		return 1;
+	}
+	return 0;
+}
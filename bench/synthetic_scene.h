@@ -0,0 +1,51 @@
+#ifndef SYNTHETIC_SCENE_H
+#define SYNTHETIC_SCENE_H
+
+#include <cmath>
+#include <vector>
+
+#include "planner.h"
+#include "waypoint_map.h"
+
+// Frame shared by the benchmarks: ego in the middle lane at 20 m/s behind a
+// slower car, traffic around it
+inline Telemetry syntheticTelemetry(const WaypointMap &map)
+{
+	Telemetry telemetry;
+	double s = 1000.0;
+	double v = 20.0;
+	std::vector<double> xy = map.getXY(s, 6.0);
+	std::vector<double> xy_next = map.getXY(s + 1.0, 6.0);
+	telemetry.car_x = xy[0];
+	telemetry.car_y = xy[1];
+	telemetry.car_s = s;
+	telemetry.car_d = 6.0;
+	telemetry.car_yaw = std::atan2(xy_next[1] - xy[1], xy_next[0] - xy[0]) * 180 / M_PI;
+	telemetry.car_speed = v / 0.44704;
+
+	for (int i = 1; i <= 40; i++)
+	{
+		std::vector<double> p = map.getXY(s + v * 0.02 * i, 6.0);
+		telemetry.previous_path_x.push_back(p[0]);
+		telemetry.previous_path_y.push_back(p[1]);
+	}
+	telemetry.end_path_s = s + v * 0.02 * 40;
+	telemetry.end_path_d = 6.0;
+
+	// id, x, y, vx, vy, s, d
+	double cars[][3] = {{25, 6, 15}, {40, 2, 18}, {-20, 2, 22}, {60, 10, 21}, {-35, 10, 19},
+						{90, 6, 17}, {120, 2, 20}, {150, 10, 16}, {-60, 6, 23}, {200, 6, 20},
+						{-90, 2, 21}, {240, 10, 22}};
+	int id = 0;
+	for (auto &car : cars)
+	{
+		double car_s = s + car[0];
+		std::vector<double> p = map.getXY(car_s, car[1]);
+		std::vector<double> q = map.getXY(car_s + 1.0, car[1]);
+		double heading = std::atan2(q[1] - p[1], q[0] - p[0]);
+		telemetry.sensor_fusion.push_back({(double)id++, p[0], p[1], car[2] * std::cos(heading), car[2] * std::sin(heading), car_s, car[1]});
+	}
+	return telemetry;
+}
+
+#endif /* SYNTHETIC_SCENE_H */
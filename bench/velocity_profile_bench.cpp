@@ -0,0 +1,78 @@
+// Generates jerk-limited speed profiles for many targets and horizons and
+// compares closed-form sampling with stepping jerk, a and v point by point.
+//
+//   velocity_profile_bench [profiles]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "velocity_profile.h"
+
+using namespace std;
+
+// the planner's original scheme: clamp jerk, a and v at every step
+static void stepped(double v0, double a0, double v_target, double a_max, double j_max, double dt, int n,
+					double *s, double *v, double *a)
+{
+	double s_i = 0.0;
+	double v_i = v0;
+	double a_i = a0;
+	for (int i = 0; i < n; i++)
+	{
+		// brake early enough to ramp a out at the target speed
+		double v_ramp = v_i + a_i * fabs(a_i) / (2 * j_max);
+		double a_desired = (v_ramp < v_target) ? a_max : -a_max;
+		double jerk = max(-j_max, min(j_max, (a_desired - a_i) / dt));
+		a_i = max(-a_max, min(a_max, a_i + jerk * dt));
+		v_i += a_i * dt;
+		s_i += v_i * dt;
+		s[i] = s_i;
+		v[i] = v_i;
+		a[i] = a_i;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int profiles = argc > 1 ? atoi(argv[1]) : 20000;
+	double dt = 0.02;
+	double a_max = 5.0;
+	double j_max = 5.0;
+
+	cout << "horizon  closed form [profiles/s]  stepped [profiles/s]  speedup" << endl;
+	for (int n : {50, 150, 500})
+	{
+		vector<double> s(n);
+		vector<double> v(n);
+		vector<double> a(n);
+		double checksum = 0.0;
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int k = 0; k < profiles; k++)
+		{
+			double v_target = 22.0 * (k % 101) / 100.0;
+			VelocityProfile profile = VelocityProfile::toSpeed(15.0, 1.0, v_target, a_max, j_max);
+			profile.sample(dt, dt, n, s.data(), v.data(), a.data());
+			checksum += v[n - 1];
+		}
+		double closed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		start = chrono::steady_clock::now();
+		for (int k = 0; k < profiles; k++)
+		{
+			double v_target = 22.0 * (k % 101) / 100.0;
+			stepped(15.0, 1.0, v_target, a_max, j_max, dt, n, s.data(), v.data(), a.data());
+			checksum += v[n - 1];
+		}
+		double step = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		cout << setw(7) << n << setw(26) << fixed << setprecision(0) << profiles / closed
+			 << setw(22) << profiles / step << setw(9) << setprecision(2) << step / closed
+			 << "  (" << setprecision(1) << checksum << ")" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,86 @@
+#include "allocation_counter.h"
+
+#ifdef COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<unsigned long> allocations(0);
+
+static void *countedAllocate(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	void *p = std::malloc(size ? size : 1);
+	if (!p)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void *operator new(std::size_t size)
+{
+	return countedAllocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+	return countedAllocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size ? size : 1);
+}
+
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+	std::free(p);
+}
+
+bool allocation_counter::enabled()
+{
+	return true;
+}
+
+unsigned long allocation_counter::count()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool allocation_counter::enabled()
+{
+	return false;
+}
+
+unsigned long allocation_counter::count()
+{
+	return 0;
+}
+
+#endif
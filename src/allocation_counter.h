@@ -0,0 +1,13 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+// Calls of the global operator new since start, from all threads. Counted
+// only in builds with COUNT_ALLOCATIONS (cmake -DCOUNT_ALLOCATIONS=ON),
+// which replace operator new and delete; otherwise always 0.
+namespace allocation_counter
+{
+bool enabled();
+unsigned long count();
+} // namespace allocation_counter
+
+#endif /* ALLOCATION_COUNTER_H */
@@ -0,0 +1,66 @@
+#include "behavior.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void IDMparameters(const MobilModel &mobil, int lane, double s_dot, double &gap, double &delta_v)
+{
+	gap = 1000;
+	delta_v = s_dot;
+
+	const LaneAssessment &assessment = mobil.lane(lane);
+	if (assessment.leader >= 0 && assessment.leader_gap < 50)
+	{
+		gap = assessment.leader_gap;
+		delta_v = s_dot - assessment.leader_speed;
+	}
+}
+
+bool isLaneChangeSafe(double car_s, int lane, int target_lane, double s_dot, const MobilModel &mobil, const OccupancyGrid &occupancy)
+{
+	return mobil.lane(target_lane).safe && occupancy.isManoeuvreFree(car_s, s_dot, lane, target_lane, 0.0, 2.0, 3.0);
+}
+
+// 0: KL, 1: LCR, -1: LCL
+// All lanes are compared at the end of the previous path, t seconds ahead: the
+// other cars from the prediction table, the ego car at constant speed s_dot.
+int makeDecision(BehaviorState &behavior, double s, double d, double s_dot, const TrafficPrediction &prediction, const OccupancyGrid &occupancy, double &actual_gap, double &delta_v, double t)
+{
+	using namespace behavior_fsm;
+
+	const MobilModel &mobil = behavior.mobil;
+	int num_lanes = mobil.numLanes();
+	int lane = std::min(std::max((int)(d / 4), 0), num_lanes - 1);
+
+	behavior.mobil.evaluate(s, lane, s_dot, prediction, t);
+
+	// the first action of the best action sequence picks the side, safety is
+	// only checked there
+	const SearchResult &plan = behavior.search.search(s, lane, s_dot, prediction);
+	unsigned inputs = 0;
+	if (plan.lane < lane)
+	{
+		inputs |= kPreferLeft;
+		inputs |= isLaneChangeSafe(s, lane, lane - 1, s_dot, mobil, occupancy) ? kLeftSafe : 0;
+	}
+	else if (plan.lane > lane)
+	{
+		inputs |= kPreferRight;
+		inputs |= isLaneChangeSafe(s, lane, lane + 1, s_dot, mobil, occupancy) ? kRightSafe : 0;
+	}
+	inputs |= (behavior.target_lane == lane) ? kInTargetLane : 0;
+
+	State previous = behavior.state;
+	behavior.state = step(previous, inputs);
+	// lane changes fix their target on entry, the other states follow the car
+	if (behavior.state != previous || kLaneOffset[behavior.state] == 0)
+	{
+		behavior.target_lane = lane + kLaneOffset[behavior.state];
+	}
+
+	// IDM follows the leader in the lane the car is in or heading for
+	IDMparameters(mobil, behavior.target_lane, s_dot, actual_gap, delta_v);
+
+	return kDecision[behavior.state];
+}
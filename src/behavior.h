@@ -0,0 +1,33 @@
+#ifndef BEHAVIOR_H
+#define BEHAVIOR_H
+
+#include <vector>
+
+#include "behavior_fsm.h"
+#include "lane_search.h"
+#include "mobil.h"
+#include "occupancy_grid.h"
+#include "prediction.h"
+
+struct BehaviorState
+{
+	behavior_fsm::State state = behavior_fsm::KeepLane;
+	int target_lane = 1;
+	// leader, follower and MOBIL safety of every lane in the last frame
+	MobilModel mobil;
+	// lookahead over lane and speed actions, picks the lane to prepare for
+	LaneSearch search;
+};
+
+// gap and s_dot - leader speed to the closest car ahead in lane within 50 m,
+// 1000 and s_dot without one
+void IDMparameters(const MobilModel &mobil, int lane, double s_dot, double &gap, double &delta_v);
+// MOBIL safety criterion, plus the occupancy grid: moving over now at constant
+// speed, the car covers both lanes for 2 s and the target lane has to stay
+// free for the next 3 s.
+bool isLaneChangeSafe(double car_s, int lane, int target_lane, double s_dot, const MobilModel &mobil, const OccupancyGrid &occupancy);
+
+// 0: KL, 1: LCR, -1: LCL
+int makeDecision(BehaviorState &behavior, double s, double d, double s_dot, const TrafficPrediction &prediction, const OccupancyGrid &occupancy, double &actual_gap, double &delta_v, double t);
+
+#endif /* BEHAVIOR_H */
@@ -0,0 +1,107 @@
+#ifndef BEHAVIOR_FSM_H
+#define BEHAVIOR_FSM_H
+
+#include <cstddef>
+
+// Behaviour state machine as data: a transition table over per-frame input
+// bits, expanded by the compiler into a dense (state, inputs) -> state table
+// so a frame costs one load. Lanes are only ever addressed relative to the
+// current one, the lane count does not appear here.
+namespace behavior_fsm
+{
+
+enum State
+{
+	KeepLane,
+	PrepareLaneChangeLeft,
+	PrepareLaneChangeRight,
+	LaneChangeLeft,
+	LaneChangeRight,
+	kNumStates
+};
+
+// inputs of one frame, one bit each
+enum Input
+{
+	kPreferLeft = 1 << 0,
+	kPreferRight = 1 << 1,
+	kLeftSafe = 1 << 2,
+	kRightSafe = 1 << 3,
+	kInTargetLane = 1 << 4,
+	kNumInputs = 1 << 5
+};
+
+// Fires in state from when (inputs & mask) == value. The first matching row
+// wins, no match keeps the state.
+struct Transition
+{
+	State from;
+	unsigned mask;
+	unsigned value;
+	State to;
+};
+
+constexpr Transition kTransitions[] = {
+	{KeepLane, kPreferLeft, kPreferLeft, PrepareLaneChangeLeft},
+	{KeepLane, kPreferRight, kPreferRight, PrepareLaneChangeRight},
+	// wait in the lane for a safe gap while the other lane is still better
+	{PrepareLaneChangeLeft, kPreferLeft, 0, KeepLane},
+	{PrepareLaneChangeLeft, kLeftSafe, kLeftSafe, LaneChangeLeft},
+	{PrepareLaneChangeRight, kPreferRight, 0, KeepLane},
+	{PrepareLaneChangeRight, kRightSafe, kRightSafe, LaneChangeRight},
+	{LaneChangeLeft, kInTargetLane, kInTargetLane, KeepLane},
+	{LaneChangeRight, kInTargetLane, kInTargetLane, KeepLane},
+};
+constexpr size_t kNumTransitions = sizeof(kTransitions) / sizeof(kTransitions[0]);
+
+// lane a state drives to, relative to the lane it is entered in
+constexpr int kLaneOffset[kNumStates] = {0, 0, 0, -1, 1};
+// 0: KL, 1: LCR, -1: LCL
+constexpr int kDecision[kNumStates] = {0, 0, 0, -1, 1};
+
+constexpr State transition(unsigned state, unsigned inputs, size_t row = 0)
+{
+	return row == kNumTransitions ? State(state)
+		   : (kTransitions[row].from == state && (inputs & kTransitions[row].mask) == kTransitions[row].value)
+			   ? kTransitions[row].to
+			   : transition(state, inputs, row + 1);
+}
+
+template <size_t... I>
+struct Indices
+{
+};
+template <size_t N, size_t... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...>
+{
+};
+template <size_t... I>
+struct MakeIndices<0, I...>
+{
+	typedef Indices<I...> type;
+};
+
+template <typename>
+struct TransitionTable;
+template <size_t... I>
+struct TransitionTable<Indices<I...>>
+{
+	static constexpr State kNext[sizeof...(I)] = {transition(I / kNumInputs, I % kNumInputs)...};
+};
+template <size_t... I>
+constexpr State TransitionTable<Indices<I...>>::kNext[sizeof...(I)];
+
+typedef TransitionTable<MakeIndices<kNumStates * kNumInputs>::type> Table;
+
+inline State step(State state, unsigned inputs)
+{
+	return Table::kNext[state * kNumInputs + (inputs & (kNumInputs - 1))];
+}
+
+static_assert(transition(KeepLane, kPreferLeft | kPreferRight) == PrepareLaneChangeLeft, "rows are tried in order");
+static_assert(transition(PrepareLaneChangeRight, kPreferRight | kRightSafe) == LaneChangeRight, "safe gap starts the change");
+static_assert(transition(LaneChangeLeft, kPreferRight) == LaneChangeLeft, "a lane change is finished first");
+
+} // namespace behavior_fsm
+
+#endif /* BEHAVIOR_FSM_H */
@@ -0,0 +1,18 @@
+#include "waypoint_map.h"
+
+#include "embedded_map_data.h"
+
+using namespace std;
+
+shared_ptr<const WaypointMap> WaypointMap::embedded()
+{
+	shared_ptr<WaypointMap> map(new WaypointMap());
+	map->waypoints_ = embedded_map::kWaypoints;
+	map->xy_ = embedded_map::kXY;
+	map->s_ = embedded_map::kS;
+	map->size_ = embedded_map::kNumWaypoints;
+	map->max_s_ = embedded_map::kMaxS;
+	map->profile_ = RoadProfile(nullptr, embedded_map::kCurvature, embedded_map::kCurvatureRate, embedded_map::kSpeedLimit,
+								embedded_map::kProfileSize, embedded_map::kProfileLanes, embedded_map::kMaxS, embedded_map::kProfileDs);
+	return map;
+}
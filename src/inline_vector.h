@@ -0,0 +1,65 @@
+#ifndef INLINE_VECTOR_H
+#define INLINE_VECTOR_H
+
+#include <cassert>
+#include <cstddef>
+
+// Vector of at most N elements stored inline, so it lives wherever its owner
+// does and never allocates. For the planner's arrays whose size is bounded at
+// compile time: spline anchors and the points of one path.
+template <typename T, std::size_t N>
+class InlineVector
+{
+public:
+	typedef T value_type;
+	typedef T *iterator;
+	typedef const T *const_iterator;
+
+	InlineVector() : size_(0) {}
+	InlineVector(const T *first, const T *last) : size_(0) { assign(first, last); }
+
+	static constexpr std::size_t capacity() { return N; }
+	std::size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+	bool full() const { return size_ == N; }
+
+	T &operator[](std::size_t i) { return data_[i]; }
+	const T &operator[](std::size_t i) const { return data_[i]; }
+	T &back() { return data_[size_ - 1]; }
+	const T &back() const { return data_[size_ - 1]; }
+	T *data() { return data_; }
+	const T *data() const { return data_; }
+
+	iterator begin() { return data_; }
+	iterator end() { return data_ + size_; }
+	const_iterator begin() const { return data_; }
+	const_iterator end() const { return data_ + size_; }
+
+	void clear() { size_ = 0; }
+	// new elements keep whatever the storage held
+	void resize(std::size_t n)
+	{
+		assert(n <= N);
+		size_ = n;
+	}
+	void push_back(const T &value)
+	{
+		assert(size_ < N);
+		data_[size_++] = value;
+	}
+	void assign(const T *first, const T *last)
+	{
+		assert(last - first <= (std::ptrdiff_t)N);
+		size_ = 0;
+		for (; first != last; ++first)
+		{
+			data_[size_++] = *first;
+		}
+	}
+
+private:
+	T data_[N];
+	std::size_t size_;
+};
+
+#endif /* INLINE_VECTOR_H */
@@ -0,0 +1,80 @@
+#include "kinematic_validator.h"
+
+#include <algorithm>
+
+#include "Eigen-3.3/Eigen/Core"
+
+using namespace std;
+
+namespace
+{
+// on the stack, never more than kMaxPoints samples
+typedef Eigen::Array<double, Eigen::Dynamic, 1, Eigen::ColMajor, KinematicValidator::kMaxPoints, 1> Samples;
+
+// unit vectors along (x, y)
+void normalize(Samples &x, Samples &y)
+{
+	Samples norm = (x.square() + y.square()).sqrt().max(1e-9);
+	x /= norm;
+	y /= norm;
+}
+} // namespace
+
+bool KinematicValidator::validate(const double *x, const double *y, int n, KinematicReport &report) const
+{
+	report = KinematicReport();
+	n = min(n, (int)kMaxPoints);
+	if (n < 2)
+	{
+		return true;
+	}
+	int w = limits_.window;
+	double dt = limits_.dt;
+	Eigen::Map<const Eigen::ArrayXd> px(x, n);
+	Eigen::Map<const Eigen::ArrayXd> py(y, n);
+
+	// speed between neighbouring points
+	int nv = n - 1;
+	Samples vx = (px.tail(nv) - px.head(nv)) / dt;
+	Samples vy = (py.tail(nv) - py.head(nv)) / dt;
+	Samples speed = (vx.square() + vy.square()).sqrt();
+	report.v_max = speed.maxCoeff();
+	report.speed_violations = (speed > limits_.v_max).count();
+
+	// acceleration over windows of w steps, split along the mean direction
+	// of travel in the window
+	int na = nv - w;
+	if (na <= 0)
+	{
+		return report.ok();
+	}
+	Samples ax = (vx.tail(na) - vx.head(na)) / (w * dt);
+	Samples ay = (vy.tail(na) - vy.head(na)) / (w * dt);
+	Samples tx = vx.tail(na) + vx.head(na);
+	Samples ty = vy.tail(na) + vy.head(na);
+	normalize(tx, ty);
+	Samples a = (ax.square() + ay.square()).sqrt();
+	report.a_max = a.maxCoeff();
+	report.a_t_max = (ax * tx + ay * ty).abs().maxCoeff();
+	report.a_n_max = (ax * ty - ay * tx).abs().maxCoeff();
+	report.acceleration_violations = (a > limits_.a_max).count();
+
+	// jerk over windows of acceleration windows
+	int nj = na - w;
+	if (nj <= 0)
+	{
+		return report.ok();
+	}
+	Samples jx = (ax.tail(nj) - ax.head(nj)) / (w * dt);
+	Samples jy = (ay.tail(nj) - ay.head(nj)) / (w * dt);
+	Samples ux = tx.tail(nj) + tx.head(nj);
+	Samples uy = ty.tail(nj) + ty.head(nj);
+	normalize(ux, uy);
+	Samples jerk = (jx.square() + jy.square()).sqrt();
+	report.jerk_max = jerk.maxCoeff();
+	report.jerk_t_max = (jx * ux + jy * uy).abs().maxCoeff();
+	report.jerk_n_max = (jx * uy - jy * ux).abs().maxCoeff();
+	report.jerk_violations = (jerk > limits_.jerk_max).count();
+
+	return report.ok();
+}
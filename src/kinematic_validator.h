@@ -0,0 +1,54 @@
+#ifndef KINEMATIC_VALIDATOR_H
+#define KINEMATIC_VALIDATOR_H
+
+// Limits the simulator enforces, acceleration and jerk as averages over a
+// window of samples
+struct KinematicLimits
+{
+	double dt = 0.02;
+	int window = 10;
+	double v_max = 50.0 * 0.44704;
+	double a_max = 10.0;
+	double jerk_max = 10.0;
+};
+
+// Extremes over one path, tangential and normal with respect to the direction
+// of travel, and the samples beyond the limits
+struct KinematicReport
+{
+	double v_max = 0.0;
+	double a_max = 0.0;
+	double a_t_max = 0.0;
+	double a_n_max = 0.0;
+	double jerk_max = 0.0;
+	double jerk_t_max = 0.0;
+	double jerk_n_max = 0.0;
+	int speed_violations = 0;
+	int acceleration_violations = 0;
+	int jerk_violations = 0;
+
+	bool ok() const { return speed_violations + acceleration_violations + jerk_violations == 0; }
+};
+
+// Finite-difference speed, acceleration and jerk of a path sampled every dt,
+// computed as whole-array Eigen expressions on fixed-capacity stack arrays,
+// so a 50-point path takes a few microseconds and nothing is allocated. Safe
+// to call from several threads.
+class KinematicValidator
+{
+public:
+	// paths longer than this are checked on their first kMaxPoints points
+	static const int kMaxPoints = 128;
+
+	explicit KinematicValidator(const KinematicLimits &limits = KinematicLimits()) : limits_(limits) {}
+
+	// n points x, y; false if any limit is exceeded
+	bool validate(const double *x, const double *y, int n, KinematicReport &report) const;
+
+	const KinematicLimits &limits() const { return limits_; }
+
+private:
+	KinematicLimits limits_;
+};
+
+#endif /* KINEMATIC_VALIDATOR_H */
@@ -0,0 +1,216 @@
+#include "lane_search.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+const int kTableSize = 1 << 13;
+} // namespace
+
+LaneSearch::LaneSearch(int num_lanes, const SearchParams &params)
+	: params_(params), num_lanes_(num_lanes), table_(kTableSize)
+{
+	int num_actions = 3 * params_.speed_factors.size();
+	nodes_.reserve(params_.max_nodes);
+	edges_.reserve(params_.max_nodes * num_actions);
+}
+
+const SearchResult &LaneSearch::search(double car_s, int lane, double s_dot, const TrafficPrediction &prediction)
+{
+	deadline_ = chrono::steady_clock::now() + chrono::microseconds((long)(params_.budget_ms * 1000));
+
+	int n = prediction.numVehicles();
+	lanes_.resize(n);
+	s0_.resize(n);
+	speeds_.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		lanes_[i] = (int)floor(prediction.d(i) / 4);
+		s0_[i] = prediction.s(i, 0);
+		speeds_[i] = prediction.speed(i);
+	}
+
+	root_s_ = car_s;
+	nodes_.clear();
+	edges_.clear();
+	result_ = SearchResult();
+	result_.lane = lane;
+
+	stamp_++;
+	addNode(lane, car_s, s_dot);
+	int begin = 0;
+	for (int level = 1; level <= params_.max_depth; level++)
+	{
+		int end = nodes_.size();
+		int edges_begin = edges_.size();
+		if (begin == end)
+		{
+			break;
+		}
+		if (!expandLevel(begin, end, level))
+		{
+			// rewind the unfinished level, every leaf is then at the same depth
+			result_.deadline_hit = true;
+			nodes_.resize(end);
+			edges_.resize(edges_begin);
+			for (int k = begin; k < end; k++)
+			{
+				nodes_[k].num_edges = 0;
+			}
+			break;
+		}
+		result_.depth = level;
+		begin = end;
+	}
+	backup();
+
+	result_.nodes = nodes_.size();
+	const Node &root = nodes_[0];
+	for (int e = root.first_edge; e < root.first_edge + root.num_edges; e++)
+	{
+		const Edge &edge = edges_[e];
+		double value = edge.reward + ((edge.child >= 0) ? params_.discount * nodes_[edge.child].value : 0.0);
+		if (value >= root.value)
+		{
+			result_.lane = edge.lane;
+			result_.value = value;
+			break;
+		}
+	}
+	return result_;
+}
+
+bool LaneSearch::expandLevel(int begin, int end, int level)
+{
+	const IdmParams &idm = params_.idm;
+	double dt = params_.step_dt;
+	double t0 = (level - 1) * dt;
+	double t1 = level * dt;
+	int num_speeds = params_.speed_factors.size();
+	int n = lanes_.size();
+
+	stamp_++;
+	for (int k = begin; k < end; k++)
+	{
+		if ((k - begin) % 16 == 0 && chrono::steady_clock::now() > deadline_)
+		{
+			return false;
+		}
+		if ((int)nodes_.size() + 3 * num_speeds > params_.max_nodes)
+		{
+			return false;
+		}
+
+		// copied, the arena grows while the node is expanded
+		Node node = nodes_[k];
+		nodes_[k].first_edge = edges_.size();
+		for (int target = max(node.lane - 1, 0); target <= min(node.lane + 1, num_lanes_ - 1); target++)
+		{
+			// closest cars ahead and behind in the target lane at t0
+			int leader = -1;
+			int follower = -1;
+			double leader_gap = 0.0;
+			double follower_gap = 0.0;
+			bool blocked = false;
+			for (int i = 0; i < n; i++)
+			{
+				if (lanes_[i] != target)
+				{
+					continue;
+				}
+				double gap = s0_[i] + speeds_[i] * t0 - node.s;
+				if (gap >= 0 && (leader < 0 || gap < leader_gap))
+				{
+					leader = i;
+					leader_gap = gap;
+				}
+				else if (gap < 0 && (follower < 0 || -gap < follower_gap))
+				{
+					follower = i;
+					follower_gap = -gap;
+				}
+			}
+			if (target != node.lane)
+			{
+				blocked = (leader >= 0 && leader_gap < params_.lane_change_gap) ||
+						  (follower >= 0 && follower_gap < params_.lane_change_gap) ||
+						  (follower >= 0 && idmAcceleration(speeds_[follower], follower_gap, node.v, true, idm) < -params_.b_safe);
+			}
+
+			for (int sp = 0; sp < num_speeds; sp++)
+			{
+				Edge edge = {-1, target, sp, -params_.collision_cost};
+				IdmParams aim = idm;
+				aim.v_desired *= params_.speed_factors[sp];
+				double a = idmAcceleration(node.v, leader_gap, (leader >= 0) ? speeds_[leader] : 0.0, leader >= 0, aim);
+				a = max(a, -2 * params_.b_safe);
+				double v = max(node.v + a * dt, 0.0);
+				double s = node.s + 0.5 * (node.v + v) * dt;
+				bool collides = blocked || (leader >= 0 && s0_[leader] + speeds_[leader] * t1 - s < idm.car_length);
+				if (!collides)
+				{
+					edge.reward = (s - node.s) - ((target != node.lane) ? params_.lane_change_cost : 0.0) -
+								  params_.brake_cost * max(-a, 0.0);
+					edge.child = addNode(target, s, v);
+				}
+				edges_.push_back(edge);
+			}
+		}
+		nodes_[k].num_edges = edges_.size() - nodes_[k].first_edge;
+	}
+	return true;
+}
+
+int LaneSearch::addNode(int lane, double s, double v)
+{
+	long s_key = lround((s - root_s_) / params_.s_resolution);
+	long v_key = lround(v / params_.v_resolution);
+	uint64_t key = ((uint64_t)lane << 48) | (((uint64_t)s_key & 0xffffff) << 24) | ((uint64_t)v_key & 0xffffff);
+
+	// open addressing, linear probing
+	size_t h = (key * 0x9E3779B97F4A7C15ull) >> 51;
+	for (int probe = 0; probe < kTableSize; probe++)
+	{
+		Slot &slot = table_[(h + probe) & (kTableSize - 1)];
+		if (slot.stamp != stamp_)
+		{
+			Node node = {lane, s, v, (int)edges_.size(), 0, 0.0};
+			slot.key = key;
+			slot.node = nodes_.size();
+			slot.stamp = stamp_;
+			nodes_.push_back(node);
+			return slot.node;
+		}
+		if (slot.key == key)
+		{
+			result_.transpositions++;
+			return slot.node;
+		}
+	}
+	return -1;
+}
+
+void LaneSearch::backup()
+{
+	// children always come after their parents in the arena
+	for (int k = nodes_.size() - 1; k >= 0; k--)
+	{
+		Node &node = nodes_[k];
+		if (node.num_edges == 0)
+		{
+			node.value = 0.0;
+			continue;
+		}
+		node.value = -params_.collision_cost;
+		for (int e = node.first_edge; e < node.first_edge + node.num_edges; e++)
+		{
+			const Edge &edge = edges_[e];
+			double value = edge.reward + ((edge.child >= 0) ? params_.discount * nodes_[edge.child].value : 0.0);
+			node.value = max(node.value, value);
+		}
+	}
+}
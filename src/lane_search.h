@@ -0,0 +1,118 @@
+#ifndef LANE_SEARCH_H
+#define LANE_SEARCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "mobil.h"
+#include "prediction.h"
+
+struct SearchParams
+{
+	IdmParams idm;
+	// one action per step, held for step_dt seconds
+	double step_dt = 1.0;
+	int max_depth = 6;
+	double discount = 0.9;
+	// iterative deepening stops when the next level would start after this
+	double budget_ms = 2.0;
+	int max_nodes = 4096;
+	// reward is metres travelled, minus these
+	double lane_change_cost = 4.0;
+	double brake_cost = 2.0;
+	double collision_cost = 1000.0;
+	// clearance to the cars of the target lane a lane change needs, and the
+	// hardest braking it may force on the new follower
+	double lane_change_gap = 8.0;
+	double b_safe = 4.0;
+	// equivalent states, merged within one level
+	double s_resolution = 1.0;
+	double v_resolution = 0.25;
+	// fractions of the IDM desired speed the ego may aim for
+	std::vector<double> speed_factors = {1.0, 0.8};
+};
+
+struct SearchResult
+{
+	// first action of the best sequence
+	int lane = 0;
+	double value = 0.0;
+	// deepest level expanded completely, nodes in the tree and states merged
+	// into an existing node
+	int depth = 0;
+	int nodes = 0;
+	int transpositions = 0;
+	bool deadline_hit = false;
+};
+
+// Lookahead over sequences of lane and speed actions against the predicted
+// traffic. The tree grows a level at a time out of a node arena allocated
+// once, equivalent states of a level share one node, and deepening stops at
+// the per-frame time budget. The last complete level is backed up.
+class LaneSearch
+{
+public:
+	explicit LaneSearch(int num_lanes = 3, const SearchParams &params = SearchParams());
+
+	// ego at car_s in lane with speed s_dot, the traffic at constant speed
+	const SearchResult &search(double car_s, int lane, double s_dot, const TrafficPrediction &prediction);
+
+	const SearchResult &result() const { return result_; }
+	const SearchParams &params() const { return params_; }
+
+private:
+	struct Node
+	{
+		int lane;
+		double s;
+		double v;
+		int first_edge;
+		int num_edges;
+		double value;
+	};
+
+	struct Edge
+	{
+		// -1 ends the sequence, a collision
+		int child;
+		int lane;
+		int speed;
+		double reward;
+	};
+
+	struct Slot
+	{
+		uint64_t key;
+		int node;
+		unsigned stamp;
+	};
+
+	// expands every node of [begin, end) into level, false if the arena or
+	// the budget ran out before all were done
+	bool expandLevel(int begin, int end, int level);
+	// node for the state, an existing one of the level if equivalent
+	int addNode(int lane, double s, double v);
+	void backup();
+
+	SearchParams params_;
+	int num_lanes_;
+	SearchResult result_;
+
+	// traffic of the frame, lane and constant speed motion
+	std::vector<int> lanes_;
+	std::vector<double> s0_;
+	std::vector<double> speeds_;
+	double root_s_ = 0.0;
+	std::chrono::steady_clock::time_point deadline_;
+
+	// arena: capacity reserved once, rewound every frame
+	std::vector<Node> nodes_;
+	std::vector<Edge> edges_;
+	// transposition table of the level being expanded, stale slots are
+	// recognized by their stamp so it is never cleared
+	std::vector<Slot> table_;
+	unsigned stamp_ = 0;
+};
+
+#endif /* LANE_SEARCH_H */
@@ -0,0 +1,226 @@
+// On-disk cache of the derived map tables. The file is a fixed header followed
+// by the tables at cache-line aligned offsets, exactly as WaypointMap reads
+// them, so loading is one mmap and a header check.
+
+#include "waypoint_map.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// bump whenever the layout of the file or of Waypoint changes
+static const uint32_t kCacheVersion = 1;
+static const char kCacheMagic[8] = {'W', 'P', 'M', 'A', 'P', 'C', 'C', '\0'};
+
+struct MapCacheHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint64_t key;
+	uint64_t file_size;
+	int32_t num_waypoints;
+	int32_t profile_size;
+	int32_t profile_lanes;
+	int32_t reserved;
+	double max_s;
+	double profile_ds;
+	uint64_t waypoints_offset;
+	uint64_t xy_offset;
+	uint64_t s_offset;
+	uint64_t kappa_offset;
+	uint64_t dkappa_offset;
+	uint64_t v_limit_offset;
+};
+
+static uint64_t alignUp(uint64_t n)
+{
+	return (n + 63) & ~uint64_t(63);
+}
+
+// FNV-1a
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t length)
+{
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+template <typename T>
+static uint64_t hashValue(uint64_t hash, T value)
+{
+	return hashBytes(hash, &value, sizeof(value));
+}
+
+static uint64_t cacheKey(const string &csv, double max_s)
+{
+	MapBuildParams params;
+	uint64_t hash = 14695981039346656037ULL;
+	hash = hashValue(hash, kCacheVersion);
+	hash = hashValue(hash, (uint32_t)sizeof(Waypoint));
+	hash = hashValue(hash, max_s);
+	hash = hashValue(hash, params.v_max);
+	hash = hashValue(hash, params.a_lat_max);
+	hash = hashValue(hash, params.a_brake);
+	hash = hashValue(hash, params.num_lanes);
+	hash = hashValue(hash, params.lane_width);
+	hash = hashValue(hash, params.ds);
+	return hashBytes(hash, csv.data(), csv.size());
+}
+
+shared_ptr<const WaypointMap> WaypointMap::fromFileCached(const string &path, double max_s)
+{
+	string csv;
+	{
+		ifstream in(path.c_str(), ifstream::in | ifstream::binary);
+		ostringstream contents;
+		contents << in.rdbuf();
+		csv = contents.str();
+	}
+	if (csv.empty())
+	{
+		return shared_ptr<const WaypointMap>(new WaypointMap());
+	}
+
+	string cache_path = path + ".cache";
+	uint64_t key = cacheKey(csv, max_s);
+
+	shared_ptr<const WaypointMap> map = fromCache(cache_path, key);
+	if (map)
+	{
+		return map;
+	}
+
+	istringstream in(csv);
+	map = fromStream(in, max_s);
+	if (map->size() >= 3 && !writeCache(*map, cache_path, key))
+	{
+		cerr << "Could not write map cache " << cache_path << endl;
+	}
+	return map;
+}
+
+shared_ptr<const WaypointMap> WaypointMap::fromCache(const string &cache_path, unsigned long long key)
+{
+	int fd = open(cache_path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return nullptr;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MapCacheHeader))
+	{
+		close(fd);
+		return nullptr;
+	}
+	size_t file_size = st.st_size;
+	void *addr = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+	{
+		return nullptr;
+	}
+	shared_ptr<const void> storage(addr, [file_size](const void *p) { munmap(const_cast<void *>(p), file_size); });
+
+	const MapCacheHeader &header = *static_cast<const MapCacheHeader *>(addr);
+	int n = header.num_waypoints;
+	int m = header.profile_size;
+	int lanes = header.profile_lanes;
+	bool valid = memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) == 0 &&
+				 header.version == kCacheVersion &&
+				 header.header_size == sizeof(MapCacheHeader) &&
+				 header.key == key &&
+				 header.file_size == file_size &&
+				 n >= 3 && m > 0 && lanes > 0 &&
+				 header.waypoints_offset + n * sizeof(Waypoint) <= file_size &&
+				 header.xy_offset + 2 * n * sizeof(double) <= file_size &&
+				 header.s_offset + n * sizeof(double) <= file_size &&
+				 header.kappa_offset + m * sizeof(double) <= file_size &&
+				 header.dkappa_offset + m * sizeof(double) <= file_size &&
+				 header.v_limit_offset + (uint64_t)lanes * m * sizeof(double) <= file_size;
+	if (!valid)
+	{
+		return nullptr;
+	}
+
+	const char *base = static_cast<const char *>(addr);
+	shared_ptr<WaypointMap> map(new WaypointMap());
+	map->storage_ = storage;
+	map->waypoints_ = reinterpret_cast<const Waypoint *>(base + header.waypoints_offset);
+	map->xy_ = reinterpret_cast<const double *>(base + header.xy_offset);
+	map->s_ = reinterpret_cast<const double *>(base + header.s_offset);
+	map->size_ = n;
+	map->max_s_ = header.max_s;
+	map->profile_ = RoadProfile(storage,
+								reinterpret_cast<const double *>(base + header.kappa_offset),
+								reinterpret_cast<const double *>(base + header.dkappa_offset),
+								reinterpret_cast<const double *>(base + header.v_limit_offset),
+								m, lanes, header.max_s, header.profile_ds);
+	return map;
+}
+
+bool WaypointMap::writeCache(const WaypointMap &map, const string &cache_path, unsigned long long key)
+{
+	const RoadProfile &profile = map.profile();
+	int n = map.size();
+	int m = profile.size();
+	int lanes = profile.numLanes();
+
+	MapCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+	header.version = kCacheVersion;
+	header.header_size = sizeof(MapCacheHeader);
+	header.key = key;
+	header.num_waypoints = n;
+	header.profile_size = m;
+	header.profile_lanes = lanes;
+	header.max_s = map.maxS();
+	header.profile_ds = profile.ds();
+	header.waypoints_offset = alignUp(sizeof(MapCacheHeader));
+	header.xy_offset = alignUp(header.waypoints_offset + n * sizeof(Waypoint));
+	header.s_offset = alignUp(header.xy_offset + 2 * n * sizeof(double));
+	header.kappa_offset = alignUp(header.s_offset + n * sizeof(double));
+	header.dkappa_offset = alignUp(header.kappa_offset + m * sizeof(double));
+	header.v_limit_offset = alignUp(header.dkappa_offset + m * sizeof(double));
+	header.file_size = header.v_limit_offset + (uint64_t)lanes * m * sizeof(double);
+
+	vector<char> image(header.file_size, 0);
+	memcpy(&image[0], &header, sizeof(header));
+	memcpy(&image[header.waypoints_offset], map.waypoints(), n * sizeof(Waypoint));
+	memcpy(&image[header.xy_offset], map.xyTable(), 2 * n * sizeof(double));
+	memcpy(&image[header.s_offset], map.sTable(), n * sizeof(double));
+	memcpy(&image[header.kappa_offset], profile.curvatureTable(), m * sizeof(double));
+	memcpy(&image[header.dkappa_offset], profile.curvatureRateTable(), m * sizeof(double));
+	memcpy(&image[header.v_limit_offset], profile.speedLimitTable(), (size_t)lanes * m * sizeof(double));
+
+	// write next to the target and rename, readers never see a partial file
+	string tmp_path = cache_path + ".tmp";
+	FILE *out = fopen(tmp_path.c_str(), "wb");
+	if (!out)
+	{
+		return false;
+	}
+	bool written = fwrite(image.data(), 1, image.size(), out) == image.size();
+	written = (fclose(out) == 0) && written;
+	if (!written || rename(tmp_path.c_str(), cache_path.c_str()) != 0)
+	{
+		remove(tmp_path.c_str());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,83 @@
+// Build-time tool: loads the waypoint CSV, computes every derived table and
+// writes them as constexpr arrays for embedded_map.cpp.
+//
+// usage: map_embedder <map.csv> <max_s> <output.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "waypoint_map.h"
+
+using namespace std;
+
+static void writeArray(FILE *out, const char *name, const double *values, int n)
+{
+	fprintf(out, "alignas(64) constexpr double %s[] = {\n", name);
+	for (int i = 0; i < n; i++)
+	{
+		fprintf(out, "%s%.17g,%s", (i % 4 == 0) ? "\t" : "", values[i], (i % 4 == 3 || i == n - 1) ? "\n" : " ");
+	}
+	fprintf(out, "};\n\n");
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 4)
+	{
+		cerr << "usage: " << argv[0] << " <map.csv> <max_s> <output.h>" << endl;
+		return 1;
+	}
+	string map_file = argv[1];
+	double max_s = atof(argv[2]);
+
+	shared_ptr<const WaypointMap> map = WaypointMap::fromFile(map_file, max_s);
+	if (map->size() < 3)
+	{
+		cerr << "Failed to load map from " << map_file << endl;
+		return 1;
+	}
+	const RoadProfile &profile = map->profile();
+
+	FILE *out = fopen(argv[3], "w");
+	if (!out)
+	{
+		cerr << "Failed to open " << argv[3] << endl;
+		return 1;
+	}
+
+	fprintf(out, "// Generated by map_embedder from %s, do not edit.\n\n", map_file.c_str());
+	fprintf(out, "#ifndef EMBEDDED_MAP_DATA_H\n#define EMBEDDED_MAP_DATA_H\n\n");
+	fprintf(out, "#include \"waypoint_map.h\"\n\n");
+	fprintf(out, "namespace embedded_map\n{\n\n");
+	fprintf(out, "constexpr double kMaxS = %.17g;\n", map->maxS());
+	fprintf(out, "constexpr int kNumWaypoints = %d;\n", map->size());
+	fprintf(out, "constexpr int kProfileSize = %d;\n", profile.size());
+	fprintf(out, "constexpr int kProfileLanes = %d;\n", profile.numLanes());
+	fprintf(out, "constexpr double kProfileDs = %.17g;\n\n", profile.ds());
+
+	fprintf(out, "alignas(64) constexpr Waypoint kWaypoints[] = {\n");
+	for (int i = 0; i < map->size(); i++)
+	{
+		const Waypoint &wp = (*map)[i];
+		fprintf(out, "\t{%.17g, %.17g, %.17g, %.17g, %.17g, %.17g, %.17g, %.17g},\n",
+				wp.x, wp.y, wp.s, wp.dx, wp.dy, wp.cos_heading, wp.sin_heading, wp.frenet_s);
+	}
+	fprintf(out, "};\n\n");
+
+	writeArray(out, "kXY", map->xyTable(), 2 * map->size());
+	writeArray(out, "kS", map->sTable(), map->size());
+	writeArray(out, "kCurvature", profile.curvatureTable(), profile.size());
+	writeArray(out, "kCurvatureRate", profile.curvatureRateTable(), profile.size());
+	writeArray(out, "kSpeedLimit", profile.speedLimitTable(), profile.numLanes() * profile.size());
+
+	fprintf(out, "} // namespace embedded_map\n\n#endif /* EMBEDDED_MAP_DATA_H */\n");
+
+	if (fclose(out) != 0)
+	{
+		cerr << "Failed to write " << argv[3] << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,114 @@
+#include "map_store.h"
+
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <pthread.h>
+
+using namespace std;
+
+MapStore::MapStore(shared_ptr<const WaypointMap> map)
+	: current_(map.get()), epoch_(0), generation_(1), reloading_(false), owner_(map)
+{
+	readers_[0].store(0);
+	readers_[1].store(0);
+}
+
+MapStore::~MapStore()
+{
+	lock_guard<mutex> lock(reload_mutex_);
+	if (reload_thread_.joinable())
+	{
+		reload_thread_.join();
+	}
+}
+
+MapStore::Snapshot MapStore::acquire() const
+{
+	// announce the reader before loading the pointer, publish() relies on
+	// it. A reader that raced with an epoch flip may have counted itself in
+	// the epoch a writer is already draining, it moves on to the new one
+	int epoch = epoch_.load();
+	while (true)
+	{
+		readers_[epoch].fetch_add(1);
+		int now = epoch_.load();
+		if (now == epoch)
+		{
+			break;
+		}
+		readers_[epoch].fetch_sub(1);
+		epoch = now;
+	}
+	return Snapshot(this, current_.load(), epoch);
+}
+
+void MapStore::publish(shared_ptr<const WaypointMap> map)
+{
+	lock_guard<mutex> lock(publish_mutex_);
+
+	current_.exchange(map.get());
+	generation_.fetch_add(1);
+
+	// grace period: anyone who could have loaded the old pointer counted
+	// itself in the old epoch before the flip. Readers from the flip on
+	// count in the new one and see the new pointer, so the old count only
+	// goes down; the previous publish already drained the new epoch
+	int old_epoch = epoch_.load();
+	epoch_.store(1 - old_epoch);
+	while (readers_[old_epoch].load() != 0)
+	{
+		this_thread::sleep_for(chrono::microseconds(100));
+	}
+	owner_ = map;
+}
+
+void MapStore::reload(const string &path, double max_s)
+{
+	shared_ptr<const WaypointMap> map = WaypointMap::fromFileCached(path, max_s);
+	if (map->size() < 3)
+	{
+		cerr << "Map reload from " << path << " failed, keeping current map" << endl;
+	}
+	else
+	{
+		publish(map);
+		cout << "Map reloaded from " << path << " (generation " << generation() << ")" << endl;
+	}
+	reloading_.store(false);
+}
+
+bool MapStore::reloadAsync(const string &path, double max_s)
+{
+	bool expected = false;
+	if (!reloading_.compare_exchange_strong(expected, true))
+	{
+		return false;
+	}
+	lock_guard<mutex> lock(reload_mutex_);
+	if (reload_thread_.joinable())
+	{
+		reload_thread_.join();
+	}
+	reload_thread_ = thread(&MapStore::reload, this, path, max_s);
+	return true;
+}
+
+void MapStore::reloadOnSignal(int signo, const string &path, double max_s)
+{
+	sigset_t set;
+	sigemptyset(&set);
+	sigaddset(&set, signo);
+	pthread_sigmask(SIG_BLOCK, &set, nullptr);
+
+	thread([this, set, path, max_s]() {
+		while (true)
+		{
+			int received;
+			if (sigwait(&set, &received) == 0)
+			{
+				reloadAsync(path, max_s);
+			}
+		}
+	}).detach();
+}
@@ -0,0 +1,87 @@
+#ifndef MAP_STORE_H
+#define MAP_STORE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "waypoint_map.h"
+
+// Holds the current WaypointMap and swaps it RCU style: readers pin the
+// current snapshot with an atomic increment and never block, a writer
+// publishes a new map with one pointer exchange and frees the old one once
+// no reader can still be using it. Readers count themselves in the current
+// one of two epochs; publishing moves new readers on to the other epoch and
+// only waits for the old one to drain, so overlapping readers on several
+// threads cannot hold the writer off for longer than one critical section.
+class MapStore
+{
+public:
+	// Read-side critical section, the map stays alive until the guard is gone.
+	// Keep it for the duration of one frame only, reclamation waits for it.
+	class Snapshot
+	{
+	public:
+		Snapshot(Snapshot &&other) : store_(other.store_), map_(other.map_), epoch_(other.epoch_) { other.store_ = nullptr; }
+		~Snapshot()
+		{
+			if (store_)
+			{
+				store_->readers_[epoch_].fetch_sub(1);
+			}
+		}
+		Snapshot(const Snapshot &) = delete;
+		Snapshot &operator=(const Snapshot &) = delete;
+
+		const WaypointMap &operator*() const { return *map_; }
+		const WaypointMap *operator->() const { return map_; }
+		const WaypointMap *get() const { return map_; }
+
+	private:
+		friend class MapStore;
+		Snapshot(const MapStore *store, const WaypointMap *map, int epoch) : store_(store), map_(map), epoch_(epoch) {}
+
+		const MapStore *store_;
+		const WaypointMap *map_;
+		int epoch_;
+	};
+
+	explicit MapStore(std::shared_ptr<const WaypointMap> map);
+	~MapStore();
+
+	Snapshot acquire() const;
+
+	// Makes map current and returns once the previous map has been released.
+	void publish(std::shared_ptr<const WaypointMap> map);
+
+	// Loads the CSV at path on a background thread and publishes it when it is
+	// valid. Returns false if a reload is already in progress.
+	bool reloadAsync(const std::string &path, double max_s);
+
+	// Reloads the map from path every time signo is delivered. Must be called
+	// before any other thread is started so they all inherit the blocked signal.
+	void reloadOnSignal(int signo, const std::string &path, double max_s);
+
+	// number of maps published so far, including the initial one
+	unsigned generation() const { return generation_.load(); }
+
+private:
+	void reload(const std::string &path, double max_s);
+
+	std::atomic<const WaypointMap *> current_;
+	// readers in each epoch, and the epoch new readers join
+	mutable std::atomic<int> readers_[2];
+	std::atomic<int> epoch_;
+	std::atomic<unsigned> generation_;
+	std::atomic<bool> reloading_;
+
+	// writer side only
+	std::mutex publish_mutex_;
+	std::shared_ptr<const WaypointMap> owner_;
+	std::mutex reload_mutex_;
+	std::thread reload_thread_;
+};
+
+#endif /* MAP_STORE_H */
@@ -0,0 +1,81 @@
+#include "mobil.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+double idmAcceleration(double v, double gap, double v_leader, bool has_leader, const IdmParams &idm)
+{
+	double free_road = 1 - pow(max(v, 0.0) / idm.v_desired, idm.delta);
+	if (!has_leader)
+	{
+		return idm.a_max * free_road;
+	}
+	double s = max(gap - idm.car_length, 0.1);
+	double s_star = idm.s_0 + max(0.0, v * idm.t_gap + v * (v - v_leader) / (2 * sqrt(idm.a_max * idm.b_comfort)));
+	return idm.a_max * (free_road - (s_star / s) * (s_star / s));
+}
+
+MobilModel::MobilModel(int num_lanes, const MobilParams &params)
+	: params_(params), lanes_(num_lanes)
+{
+}
+
+void MobilModel::evaluate(double car_s, int lane, double s_dot, const TrafficPrediction &prediction, double t)
+{
+	const IdmParams &idm = params_.idm;
+	int num_lanes = lanes_.size();
+	ego_lane_ = min(max(lane, 0), num_lanes - 1);
+	for (int l = 0; l < num_lanes; l++)
+	{
+		lanes_[l] = LaneAssessment();
+	}
+
+	// one pass: closest car ahead and behind in every lane
+	double ego_s = car_s + s_dot * t;
+	for (int i = 0; i < prediction.numVehicles(); i++)
+	{
+		int l = (int)floor(prediction.d(i) / 4);
+		if (l < 0 || l >= num_lanes)
+		{
+			continue;
+		}
+		LaneAssessment &assessment = lanes_[l];
+		double gap = prediction.sAt(i, t) - ego_s;
+		if (gap >= 0 && (assessment.leader < 0 || gap < assessment.leader_gap))
+		{
+			assessment.leader = i;
+			assessment.leader_gap = gap;
+			assessment.leader_speed = prediction.speed(i);
+		}
+		else if (gap < 0 && (assessment.follower < 0 || -gap < assessment.follower_gap))
+		{
+			assessment.follower = i;
+			assessment.follower_gap = -gap;
+			assessment.follower_speed = prediction.speed(i);
+		}
+	}
+
+	for (int l = 0; l < num_lanes; l++)
+	{
+		LaneAssessment &assessment = lanes_[l];
+		if (l == ego_lane_)
+		{
+			assessment.safe = true;
+			continue;
+		}
+
+		// the new follower gets the ego as its leader
+		double new_follower_after = 0.0;
+		if (assessment.follower >= 0)
+		{
+			new_follower_after = idmAcceleration(assessment.follower_speed, assessment.follower_gap, s_dot, true, idm);
+		}
+
+		// no car alongside, and the new follower does not have to brake hard
+		bool overlap = (assessment.leader >= 0 && assessment.leader_gap < idm.car_length) ||
+					   (assessment.follower >= 0 && assessment.follower_gap < idm.car_length);
+		assessment.safe = !overlap && new_follower_after >= -params_.b_safe;
+	}
+}
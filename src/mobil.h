@@ -0,0 +1,68 @@
+#ifndef MOBIL_H
+#define MOBIL_H
+
+#include <vector>
+
+#include "prediction.h"
+
+// Intelligent Driver Model used to rate lanes for every car alike
+struct IdmParams
+{
+	double v_desired = 48.0 * 0.44704;
+	double a_max = 1.5;
+	double b_comfort = 2.0;
+	// minimum bumper-to-bumper gap and time headway
+	double s_0 = 2.0;
+	double t_gap = 1.0;
+	double delta = 4.0;
+	double car_length = 5.0;
+};
+
+// acceleration at speed v behind a leader gap (centre to centre) ahead at
+// v_leader, free road when there is no leader
+double idmAcceleration(double v, double gap, double v_leader, bool has_leader, const IdmParams &idm);
+
+struct MobilParams
+{
+	IdmParams idm;
+	// hardest braking a lane change may force on the new follower
+	double b_safe = 4.0;
+};
+
+struct LaneAssessment
+{
+	// closest cars ahead and behind at the check time, -1 if none
+	int leader = -1;
+	int follower = -1;
+	// centre to centre distances along s
+	double leader_gap = 0.0;
+	double leader_speed = 0.0;
+	double follower_gap = 0.0;
+	double follower_speed = 0.0;
+	// MOBIL safety criterion: no car alongside, and the new follower would
+	// not have to brake harder than b_safe
+	bool safe = false;
+};
+
+// Lane assessment: one pass over the predicted traffic finds leader and
+// follower in every lane, then MOBIL's safety criterion rates moving into
+// each. Which lane to move to is up to the lane search.
+class MobilModel
+{
+public:
+	explicit MobilModel(int num_lanes = 3, const MobilParams &params = MobilParams());
+
+	// ego at car_s in lane with speed s_dot, everything compared t seconds ahead
+	void evaluate(double car_s, int lane, double s_dot, const TrafficPrediction &prediction, double t);
+
+	int numLanes() const { return lanes_.size(); }
+	const LaneAssessment &lane(int lane) const { return lanes_[lane]; }
+	const MobilParams &params() const { return params_; }
+
+private:
+	MobilParams params_;
+	int ego_lane_ = 0;
+	std::vector<LaneAssessment> lanes_;
+};
+
+#endif /* MOBIL_H */
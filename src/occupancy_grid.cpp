@@ -0,0 +1,112 @@
+#include "occupancy_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+OccupancyGrid::OccupancyGrid(int num_lanes, int t_bins, double dt, double s_res, double s_behind)
+	: num_lanes_(num_lanes), t_bins_(t_bins), dt_(dt), s_res_(s_res), s_behind_(s_behind),
+	  bits_(num_lanes * t_bins * kWords, 0)
+{
+}
+
+void OccupancyGrid::clear(double ego_s)
+{
+	s_origin_ = ego_s - s_behind_;
+	fill(bits_.begin(), bits_.end(), 0);
+}
+
+bool OccupancyGrid::rangeMask(double s_lo, double s_hi, uint64_t mask[kWords]) const
+{
+	int lo = (int)floor((s_lo - s_origin_) / s_res_);
+	int hi = (int)floor((s_hi - s_origin_) / s_res_);
+	lo = max(lo, 0);
+	hi = min(hi, kSBins - 1);
+	if (lo > hi)
+	{
+		return false;
+	}
+	for (int w = 0; w < kWords; w++)
+	{
+		int a = max(lo, 64 * w) - 64 * w;
+		int b = min(hi, 64 * w + 63) - 64 * w;
+		mask[w] = (a > b) ? 0 : ((~0ULL) >> (63 - (b - a))) << a;
+	}
+	return true;
+}
+
+void OccupancyGrid::mark(int lane, int t, double s_lo, double s_hi)
+{
+	uint64_t mask[kWords];
+	if (lane < 0 || lane >= num_lanes_ || t < 0 || t >= t_bins_ || !rangeMask(s_lo, s_hi, mask))
+	{
+		return;
+	}
+	uint64_t *bits = row(lane, t);
+	for (int w = 0; w < kWords; w++)
+	{
+		bits[w] |= mask[w];
+	}
+}
+
+void OccupancyGrid::build(const TrafficPrediction &prediction, double ego_s, double car_length, double margin)
+{
+	clear(ego_s);
+	int steps = min(t_bins_, prediction.numSteps());
+	double half = 0.5 * car_length + margin;
+	for (int i = 0; i < prediction.numVehicles(); i++)
+	{
+		// lanes touched by a car 2 m wide
+		double d = prediction.d(i);
+		int lane_lo = (int)floor((d - 1.0) / 4.0);
+		int lane_hi = (int)floor((d + 1.0) / 4.0);
+		const double *s = prediction.row(i);
+		for (int lane = max(lane_lo, 0); lane <= min(lane_hi, num_lanes_ - 1); lane++)
+		{
+			for (int t = 0; t < steps; t++)
+			{
+				mark(lane, t, s[t] - half, s[t] + half);
+			}
+		}
+	}
+}
+
+bool OccupancyGrid::isManoeuvreFree(double s, double s_dot, int lane, int target_lane, double t_start, double t_end,
+									double horizon, double car_length) const
+{
+	int steps = min(t_bins_, (int)(horizon / dt_) + 1);
+	double half = 0.5 * car_length;
+	for (int t = 0; t < steps; t++)
+	{
+		double time = t * dt_;
+		double ego_s = s + s_dot * time;
+		bool in_lane = (lane == target_lane) || time <= t_end;
+		bool in_target = (lane != target_lane) && time >= t_start;
+		if (in_lane && !isFree(lane, t, ego_s - half, ego_s + half))
+		{
+			return false;
+		}
+		if (in_target && !isFree(target_lane, t, ego_s - half, ego_s + half))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool OccupancyGrid::isFree(int lane, int t, double s_lo, double s_hi) const
+{
+	uint64_t mask[kWords];
+	if (lane < 0 || lane >= num_lanes_ || t < 0 || t >= t_bins_ || !rangeMask(s_lo, s_hi, mask))
+	{
+		return true;
+	}
+	const uint64_t *bits = row(lane, t);
+	uint64_t hit = 0;
+	for (int w = 0; w < kWords; w++)
+	{
+		hit |= bits[w] & mask[w];
+	}
+	return hit == 0;
+}
@@ -0,0 +1,55 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <cstdint>
+#include <vector>
+
+#include "prediction.h"
+
+// Bitset occupancy over (lane, t-bin, s-bin) in Frenet space, relative to the
+// ego s at the time it was built. Each (lane, t) row is kWords 64-bit words of
+// s-bins, so testing a footprint cell against the traffic is kWords bitwise
+// ANDs.
+class OccupancyGrid
+{
+public:
+	static const int kWords = 2;
+	static const int kSBins = 64 * kWords;
+
+	// s-bins of s_res metres starting s_behind metres behind the ego car,
+	// one t-bin per prediction step
+	OccupancyGrid(int num_lanes = 3, int t_bins = 51, double dt = 0.1, double s_res = 2.0, double s_behind = 56.0);
+
+	void clear(double ego_s);
+	// rasterizes every predicted vehicle, inflated by half a car length plus
+	// margin; cars straddling a lane line occupy both lanes
+	void build(const TrafficPrediction &prediction, double ego_s, double car_length = 5.0, double margin = 6.0);
+
+	// marks [s_lo, s_hi] (absolute s) in lane at t-bin t
+	void mark(int lane, int t, double s_lo, double s_hi);
+	bool isFree(int lane, int t, double s_lo, double s_hi) const;
+	// ego footprint of a lane keep or lane change at constant speed is free,
+	// the car covers both lanes between t_start and t_end, and target_lane after
+	bool isManoeuvreFree(double s, double s_dot, int lane, int target_lane, double t_start, double t_end,
+						 double horizon, double car_length = 5.0) const;
+
+	int numLanes() const { return num_lanes_; }
+	int numTimeBins() const { return t_bins_; }
+	double dt() const { return dt_; }
+
+private:
+	uint64_t *row(int lane, int t) { return &bits_[(lane * t_bins_ + t) * kWords]; }
+	const uint64_t *row(int lane, int t) const { return &bits_[(lane * t_bins_ + t) * kWords]; }
+	// word masks covering the s-bins of [s_lo, s_hi], false if outside the window
+	bool rangeMask(double s_lo, double s_hi, uint64_t mask[kWords]) const;
+
+	int num_lanes_;
+	int t_bins_;
+	double dt_;
+	double s_res_;
+	double s_behind_;
+	double s_origin_ = 0.0;
+	std::vector<uint64_t> bits_;
+};
+
+#endif /* OCCUPANCY_GRID_H */
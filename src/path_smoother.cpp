@@ -0,0 +1,91 @@
+#include "path_smoother.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "spline.h"
+
+using namespace std;
+
+struct PathSmoother::System
+{
+	tk::band_matrix A;
+};
+
+double LateralProfile::dAt(double s) const
+{
+	int n = d.size();
+	if (n == 0)
+	{
+		return 0.0;
+	}
+	double k = (s - s0) / ds;
+	if (k <= 0.0)
+	{
+		return d[0];
+	}
+	if (k >= n - 1)
+	{
+		return d[n - 1];
+	}
+	int k0 = (int)k;
+	return d[k0] + (k - k0) * (d[k0 + 1] - d[k0]);
+}
+
+PathSmoother::PathSmoother(const PathSmootherParams &params)
+	: params_(params), system_(new System()), rhs_(params.points)
+{
+	int n = params_.points;
+	tk::band_matrix &A = system_->A;
+	A.resize(n, 3, 3);
+
+	// adds w * D^T D for the difference stencil D placed at row i
+	auto addStencil = [&A, n](const double *stencil, int width, double w) {
+		for (int i = 0; i + width <= n; i++)
+		{
+			for (int r = 0; r < width; r++)
+			{
+				for (int c = 0; c < width; c++)
+				{
+					A(i + r, i + c) += w * stencil[r] * stencil[c];
+				}
+			}
+		}
+	};
+	static const double second[] = {1.0, -2.0, 1.0};
+	static const double third[] = {-1.0, 3.0, -3.0, 1.0};
+	double ds2 = params_.ds * params_.ds;
+	addStencil(second, 3, params_.w_curvature / (ds2 * ds2));
+	addStencil(third, 4, params_.w_curvature_rate / (ds2 * ds2 * ds2));
+	for (int i = 0; i < n; i++)
+	{
+		A(i, i) += params_.w_offset + params_.w_previous;
+	}
+	A(0, 0) += params_.w_pin;
+	A(1, 1) += params_.w_pin;
+	A.lu_decompose();
+}
+
+PathSmoother::~PathSmoother()
+{
+}
+
+void PathSmoother::smooth(double s0, double d0, double slope0, double d_target, LateralProfile &profile)
+{
+	int n = params_.points;
+	double ds = params_.ds;
+	bool warm = (int)profile.d.size() == n;
+	for (int i = 0; i < n; i++)
+	{
+		double previous = warm ? profile.dAt(s0 + i * ds) : d_target;
+		rhs_[i] = params_.w_offset * d_target + params_.w_previous * previous;
+	}
+	rhs_[0] += params_.w_pin * d0;
+	rhs_[1] += params_.w_pin * (d0 + slope0 * ds);
+	system_->A.lu_solve_inplace(rhs_);
+
+	profile.s0 = s0;
+	profile.ds = ds;
+	profile.d.swap(rhs_);
+	rhs_.resize(n);
+}
@@ -0,0 +1,59 @@
+#ifndef PATH_SMOOTHER_H
+#define PATH_SMOOTHER_H
+
+#include <memory>
+#include <vector>
+
+struct PathSmootherParams
+{
+	// stations every ds metres
+	int points = 20;
+	double ds = 5.0;
+	// weights of the distance to the target offset, curvature, curvature
+	// rate and the distance to the previous frame's solution
+	double w_offset = 1.0;
+	double w_curvature = 3e4;
+	double w_curvature_rate = 3e5;
+	double w_previous = 0.5;
+	// start offset and heading are pinned with this weight
+	double w_pin = 1e6;
+};
+
+// Frenet d at stations s0 + i * ds
+struct LateralProfile
+{
+	double s0 = 0.0;
+	double ds = 0.0;
+	std::vector<double> d;
+
+	// linear between stations, held beyond them
+	double dAt(double s) const;
+};
+
+// Least-squares lateral path: offsets at evenly spaced stations that trade
+// the target offset against curvature and curvature rate, as finite
+// differences. The normal equations are a symmetric band matrix of half
+// bandwidth 3 that only depends on the weights, so it is factorized once and
+// every frame is two in-place triangular solves.
+class PathSmoother
+{
+public:
+	explicit PathSmoother(const PathSmootherParams &params = PathSmootherParams());
+	~PathSmoother();
+
+	// starts at s0 with offset d0 and slope dd/ds, pulled towards d_target.
+	// profile holds the previous solution, which the new one is kept close
+	// to, and is overwritten by the new one
+	void smooth(double s0, double d0, double slope0, double d_target, LateralProfile &profile);
+
+	const PathSmootherParams &params() const { return params_; }
+
+private:
+	struct System;
+
+	PathSmootherParams params_;
+	std::unique_ptr<System> system_;
+	std::vector<double> rhs_;
+};
+
+#endif /* PATH_SMOOTHER_H */
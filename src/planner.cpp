@@ -0,0 +1,723 @@
+#include "planner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "spline.h"
+#include "velocity_profile.h"
+
+using namespace std;
+
+static double distance(double x1, double y1, double x2, double y2)
+{
+	return sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+}
+
+// The anchors of a slot move by a few percent from frame to frame, within
+// that the last decomposition is reused. The slot's path is kept as well, so
+// its coefficient and arc length tables are refitted in place
+struct SplineFitCache
+{
+	SplineFitCache() : factorization(0.05) {}
+	tk::spline_factorization factorization;
+	tk::parametric_spline path;
+};
+
+Planner::Planner(int num_threads, double frame_budget_ms)
+	: frame_budget_ms_(frame_budget_ms), pool_(num_threads)
+{
+}
+
+Planner::~Planner()
+{
+}
+
+void Planner::setParams(const PlannerParams &params)
+{
+	params_.reset(new PlannerParams(params));
+}
+
+void Planner::plan(const Telemetry &telemetry, const WaypointMap &map, TrajectoryBuffer &trajectory,
+				   vector<double> &next_x_vals, vector<double> &next_y_vals)
+{
+	if (params_)
+	{
+		planFrame(*params_, telemetry, map, trajectory, next_x_vals, next_y_vals);
+	}
+	else
+	{
+		planFrame(StaticPlannerParams(), telemetry, map, trajectory, next_x_vals, next_y_vals);
+	}
+}
+
+template <typename Params>
+void Planner::planFrame(const Params &params, const Telemetry &telemetry, const WaypointMap &map, TrajectoryBuffer &trajectory,
+						vector<double> &next_x_vals, vector<double> &next_y_vals)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	const vector<double> &previous_path_x = telemetry.previous_path_x;
+	const vector<double> &previous_path_y = telemetry.previous_path_y;
+	double car_x = telemetry.car_x;
+	double car_y = telemetry.car_y;
+	double car_s = telemetry.car_s;
+	double car_d = telemetry.car_d;
+
+	double delta_t_ = 0.02;
+	double ref_yaw = telemetry.car_yaw * M_PI / 180;
+	double ref_x = car_x;
+	double ref_y = car_y;
+	// off the road the closest lane, the lane tables have no entry for it
+	int lane = max(0, min((int)floor(car_d / params.lane_width), behavior_.mobil.numLanes() - 1));
+	double car_v = telemetry.car_speed * 0.44704;
+
+	int prev_size = previous_path_x.size();
+	int number_of_point_from_prev_path = params.kept_points;
+
+	// drop what the simulator drove since the last frame, the states of
+	// the rest of the previous path are then known exactly
+	bool synced = trajectory.resync(previous_path_x, previous_path_y);
+	if (synced)
+	{
+		// arc length along the path drifts away from Frenet s, re-anchor it
+		// on the simulator's car_s every frame
+		trajectory.shiftS(car_s + distance(car_x, car_y, trajectory[0].x, trajectory[0].y) - trajectory[0].s);
+	}
+
+	//Status
+	cout << " ----------------------------------------------- " << endl;
+	cout << "car_v: " << car_v << endl;
+
+	//Make Decision
+	double delta_v = car_v;
+	double actual_gap = 100;
+	// predict every other car once, over the whole horizon; the checks
+	// look at the end of the previous path
+	prediction_.update(telemetry.sensor_fusion);
+	occupancy_.build(prediction_, car_s);
+	behavior_fsm::State previous_state = behavior_.state;
+	int decision = makeDecision(behavior_, car_s, car_d, car_v, prediction_, occupancy_, actual_gap, delta_v, prev_size * delta_t_);
+	stats_.lane_changes += behavior_.state != previous_state && behavior_fsm::kLaneOffset[behavior_.state] != 0;
+
+	cout << "decision: " << decision << endl;
+	cout << "delta_v: " << delta_v << endl;
+	cout << "actual_gap: " << actual_gap << endl;
+
+	FrameContext ctx;
+	ctx.telemetry = &telemetry;
+	ctx.map = &map;
+	ctx.prediction = &prediction_;
+	ctx.occupancy = &occupancy_;
+	ctx.lane = lane;
+	ctx.car_v = car_v;
+	ctx.target_lane = behavior_.target_lane;
+	ctx.target_gap = actual_gap;
+	ctx.target_delta_v = delta_v;
+	ctx.t_check = prev_size * delta_t_;
+	ctx.a_prev = 0.0;
+	ctx.number = std::min(prev_size, number_of_point_from_prev_path);
+	kept_points_ = ctx.number;
+
+	// s of the first point the new trajectory is anchored on
+	ctx.ref_s = car_s;
+	if (prev_size < number_of_point_from_prev_path)
+	{
+		ctx.anchor_x[0] = car_x - cos(ref_yaw);
+		ctx.anchor_y[0] = car_y - sin(ref_yaw);
+		ctx.anchor_x[1] = car_x;
+		ctx.anchor_y[1] = car_y;
+
+		ctx.v_prev = car_v;
+	}
+	else
+	{
+		ref_x = previous_path_x[number_of_point_from_prev_path - 1];
+		ref_y = previous_path_y[number_of_point_from_prev_path - 1];
+		double ref_x_prev = previous_path_x[number_of_point_from_prev_path - 2];
+		double ref_y_prev = previous_path_y[number_of_point_from_prev_path - 2];
+		ref_yaw = atan2(ref_y - ref_y_prev, ref_x - ref_x_prev);
+
+		if (synced)
+		{
+			const TrajectoryPoint &ref = trajectory[number_of_point_from_prev_path - 1];
+			ctx.v_prev = ref.v;
+			ctx.a_prev = ref.a;
+			ctx.ref_s = ref.s;
+		}
+		else
+		{
+			ctx.v_prev = distance(ref_x, ref_y, ref_x_prev, ref_y_prev) / delta_t_;
+			ctx.ref_s += distance(car_x, car_y, ref_x, ref_y);
+		}
+
+		ctx.anchor_x[0] = ref_x_prev;
+		ctx.anchor_y[0] = ref_y_prev;
+		ctx.anchor_x[1] = ref_x;
+		ctx.anchor_y[1] = ref_y;
+	}
+	ctx.ref_x = ref_x;
+	ctx.ref_y = ref_y;
+	ctx.ref_yaw = ref_yaw;
+
+	cout << "v_prev: " << ctx.v_prev << endl;
+	cout << "a_prev_prev: " << ctx.a_prev << endl;
+
+	// speed plans of the lanes candidates can take, from the first new point
+	speed_profiles_.resize(behavior_.mobil.numLanes());
+	for (size_t l = 0; l < speed_profiles_.size(); l++)
+	{
+		speed_profiles_[l].feasible = false;
+	}
+	int plan_lanes[2] = {ctx.target_lane, ctx.lane};
+	for (int l : plan_lanes)
+	{
+		if (l < 0 || l >= (int)speed_profiles_.size() || speed_profiles_[l].feasible)
+		{
+			continue;
+		}
+		double v_limit = std::min((double)params.v_max, map.profile().maxSpeedAt(ctx.ref_s, l));
+		speed_planner_.plan(ctx.ref_s, ctx.v_prev, ctx.a_prev, v_limit, l, ctx.number * delta_t_, prediction_,
+							speed_profiles_[l]);
+	}
+	ctx.speed_profiles = &speed_profiles_;
+
+	// smoothed lateral paths of the same lanes, from the offset and slope
+	// the kept points end with; lanes left out lose their warm start
+	double s_ref, d_ref, s_prev, d_prev;
+	map.getFrenet(ctx.ref_x, ctx.ref_y, ctx.ref_yaw, s_ref, d_ref);
+	map.getFrenet(ctx.anchor_x[0], ctx.anchor_y[0], ctx.ref_yaw, s_prev, d_prev);
+	double anchor_step = distance(ctx.anchor_x[0], ctx.anchor_y[0], ctx.ref_x, ctx.ref_y);
+	double slope = (anchor_step > 1e-3) ? (d_ref - d_prev) / anchor_step : 0.0;
+	lateral_profiles_.resize(speed_profiles_.size());
+	for (int l = 0; l < (int)lateral_profiles_.size(); l++)
+	{
+		if (l == plan_lanes[0] || l == plan_lanes[1])
+		{
+			path_smoother_.smooth(ctx.ref_s, d_ref, slope, (l + 0.5) * params.lane_width, lateral_profiles_[l]);
+		}
+		else
+		{
+			lateral_profiles_[l].d.clear();
+		}
+	}
+	ctx.lateral_profiles = &lateral_profiles_;
+
+	buildCandidates(ctx);
+	while (fit_caches_.size() < num_candidates_)
+	{
+		fit_caches_.emplace_back(new SplineFitCache());
+	}
+	for (size_t i = 0; i < num_candidates_; i++)
+	{
+		candidates_[i].fit_cache = fit_caches_[i].get();
+	}
+
+	// anytime: the fallback (keep lane, IDM braking behind its leader) is
+	// always ready, refinements run on the pool in order of preference
+	// until the deadline and the best one finished by then is sent
+	evaluate(ctx, candidates_[0]);
+
+	ctx.deadline = start + chrono::microseconds((long)(frame_budget_ms_ * 1000));
+	pool_.parallelFor(num_candidates_ - 1, [this, &ctx](int i) {
+		if (chrono::steady_clock::now() > ctx.deadline)
+		{
+			return;
+		}
+		evaluate(ctx, candidates_[i + 1]);
+	});
+
+	stats_.frames++;
+	int evaluated = 0;
+	for (size_t i = 0; i < num_candidates_; i++)
+	{
+		evaluated += candidates_[i].evaluated;
+	}
+	stats_.candidates_evaluated += evaluated;
+	for (size_t i = 0; i < num_candidates_; i++)
+	{
+		stats_.candidates_rejected += candidates_[i].evaluated && !candidates_[i].kinematics.ok();
+	}
+	stats_.spline_fits = 0;
+	stats_.spline_fits_reused = 0;
+	for (size_t i = 0; i < fit_caches_.size(); i++)
+	{
+		const tk::spline_factorization &factorization = fit_caches_[i]->factorization;
+		stats_.spline_fits += factorization.hits() + factorization.misses();
+		stats_.spline_fits_reused += factorization.hits();
+	}
+	stats_.candidates_skipped += num_candidates_ - evaluated;
+	if (evaluated < (int)num_candidates_)
+	{
+		stats_.deadline_hits++;
+	}
+
+	int best = 0;
+	for (size_t i = 1; i < num_candidates_; i++)
+	{
+		if (candidates_[i].evaluated && candidates_[i].cost < candidates_[best].cost)
+		{
+			best = i;
+		}
+	}
+	Candidate &chosen = candidates_[best];
+
+	if (!chosen.kinematics.ok())
+	{
+		stats_.kinematic_violations++;
+	}
+
+	// a manoeuvre the behaviour layer did not ask for means its lane change
+	// turned out unsafe, fall back to keeping the chosen lane
+	if (chosen.spec.lane != behavior_.target_lane)
+	{
+		behavior_.target_lane = chosen.spec.lane;
+		behavior_.state = behavior_fsm::KeepLane;
+	}
+	emit(ctx, chosen, trajectory);
+
+	next_x_vals.assign(chosen.x.begin(), chosen.x.end());
+	next_y_vals.assign(chosen.y.begin(), chosen.y.end());
+}
+
+void Planner::buildCandidates(const FrameContext &ctx)
+{
+	static const double speed_factors[] = {1.0, 0.9, 0.75};
+	static const double anchor_distances[] = {30.0, 40.0, 50.0};
+
+	int lanes[2] = {ctx.target_lane, ctx.lane};
+	int num_lanes = (ctx.lane == ctx.target_lane) ? 1 : 2;
+
+	// candidates are written into the slots of earlier frames, slots beyond
+	// the count are kept for later frames
+	size_t count = 0;
+	auto add = [this, &count](const CandidateSpec &spec) {
+		if (count == candidates_.size())
+		{
+			candidates_.emplace_back();
+		}
+		Candidate &candidate = candidates_[count++];
+		candidate.spec = spec;
+		candidate.cost = 0.0;
+		candidate.evaluated = false;
+	};
+
+	// fallback first: keep the current lane, follow its leader
+	CandidateSpec fallback;
+	fallback.lane = ctx.lane;
+	fallback.speed_source = SpeedSource::Idm;
+	fallback.path_source = PathSource::Anchors;
+	fallback.speed_factor = speed_factors[0];
+	fallback.anchor_distance = anchor_distances[0];
+	add(fallback);
+
+	// then the behaviour layer's manoeuvre and its variations
+	for (int l = 0; l < num_lanes; l++)
+	{
+		for (double speed_factor : speed_factors)
+		{
+			// full speed follows the lane's speed plan when there is one
+			SpeedSource speed_source = SpeedSource::SCurve;
+			if (speed_factor == 1.0)
+			{
+				bool planned = lanes[l] < (int)ctx.speed_profiles->size() && (*ctx.speed_profiles)[lanes[l]].feasible;
+				speed_source = planned ? SpeedSource::StGraph : SpeedSource::Idm;
+			}
+			for (double anchor_distance : anchor_distances)
+			{
+				if (lanes[l] == fallback.lane && speed_source == fallback.speed_source &&
+					speed_factor == fallback.speed_factor && anchor_distance == fallback.anchor_distance)
+				{
+					continue;
+				}
+				CandidateSpec spec;
+				spec.lane = lanes[l];
+				spec.speed_source = speed_source;
+				spec.path_source = PathSource::Anchors;
+				spec.speed_factor = speed_factor;
+				spec.anchor_distance = anchor_distance;
+				add(spec);
+			}
+			// and the lane's smoothed path at full speed
+			if (speed_factor == 1.0 && !(*ctx.lateral_profiles)[lanes[l]].d.empty())
+			{
+				CandidateSpec spec;
+				spec.lane = lanes[l];
+				spec.speed_source = speed_source;
+				spec.path_source = PathSource::Smoothed;
+				spec.speed_factor = speed_factor;
+				spec.anchor_distance = 0.0;
+				add(spec);
+			}
+		}
+	}
+	num_candidates_ = count;
+}
+
+void Planner::evaluate(const FrameContext &ctx, Candidate &candidate) const
+{
+	if (params_)
+	{
+		generate(*params_, ctx, candidate);
+		candidate.cost = cost(*params_, ctx, candidate);
+	}
+	else
+	{
+		StaticPlannerParams params;
+		generate(params, ctx, candidate);
+		candidate.cost = cost(params, ctx, candidate);
+	}
+	candidate.evaluated = true;
+}
+
+template <typename Params>
+void Planner::generate(const Params &params, const FrameContext &ctx, Candidate &candidate) const
+{
+	const Telemetry &telemetry = *ctx.telemetry;
+	const WaypointMap &map = *ctx.map;
+	int lane = candidate.spec.lane;
+	double car_v = ctx.car_v;
+	double delta_t_ = 0.02;
+
+	PathValues &next_x_vals = candidate.x;
+	PathValues &next_y_vals = candidate.y;
+	next_x_vals.clear();
+	next_y_vals.clear();
+
+	double a_max = params.a_max;
+	double a_min = -params.a_max;
+
+	double jerk_max = params.jerk_max;
+	double jerk_min = -params.jerk_max;
+	double v_max = params.v_max;
+	double v_min = params.v_min;
+
+	// curve-aware desired speed for IDM
+	v_max = std::min(v_max, map.profile().maxSpeedAt(ctx.ref_s, lane)) * candidate.spec.speed_factor;
+
+	double actual_gap = ctx.target_gap;
+	double delta_v = ctx.target_delta_v;
+	if (lane != ctx.target_lane)
+	{
+		IDMparameters(behavior_.mobil, lane, car_v, actual_gap, delta_v);
+	}
+
+	double a_prev_prev = ctx.a_prev;
+
+	double s_0 = params.s_0;
+	double t_gap = params.t_gap;
+	double a_acc = params.a_acc;
+	double a_dec = params.a_dec;
+	double s_star = s_0 + std::max(0.0, (car_v * t_gap + car_v * delta_v / (2 * sqrt(a_acc * a_dec))));
+
+	if (actual_gap == 0.0)
+		actual_gap = 1.0;
+	double desired_a_prev = a_acc * (1 - ((car_v) / (v_max)) - (s_star / actual_gap) * (s_star / actual_gap));
+
+	// s-t candidates track their lane's speed plan instead, aiming for the
+	// planned speed t_track ahead
+	const SpeedProfile *speed_plan = nullptr;
+	double t_track = 0.5;
+	if (candidate.spec.speed_source == SpeedSource::StGraph)
+	{
+		speed_plan = &(*ctx.speed_profiles)[lane];
+		desired_a_prev = (speed_plan->speedAt(t_track) - ctx.v_prev) / t_track;
+	}
+
+	desired_a_prev = std::min(desired_a_prev, a_max);
+	desired_a_prev = std::max(desired_a_prev, a_min);
+
+	double jerk = (desired_a_prev - a_prev_prev) / delta_t_;
+	jerk = std::min(jerk, jerk_max);
+	jerk = std::max(jerk, jerk_min);
+
+	double a = a_prev_prev + jerk * delta_t_;
+	a = std::max(a, a_min);
+	a = std::min(a, a_max);
+	double v = ctx.v_prev + a * delta_t_;
+
+	v = std::max(v, v_min);
+	v = std::min(v, v_max);
+
+	double a_end = a;
+	candidate.states.clear();
+
+	// speed-target candidates follow a jerk-limited S-curve to their
+	// desired speed instead of IDM, sampled once for the whole horizon
+	int num_new = kHorizon - ctx.number;
+	bool s_curve = candidate.spec.speed_source == SpeedSource::SCurve;
+	double profile_s[kHorizon + 1];
+	double profile_v[kHorizon + 1];
+	double profile_a[kHorizon + 1];
+	if (s_curve)
+	{
+		// no faster than the leader IDM follows, the cost only looks a
+		// second ahead, too late to brake for it
+		double v_target = (actual_gap < 1000) ? std::max(0.0, std::min(v_max, car_v - delta_v)) : v_max;
+		VelocityProfile profile = VelocityProfile::toSpeed(ctx.v_prev, ctx.a_prev, v_target, params.a_comfort, params.jerk_comfort);
+		profile.sample(delta_t_, delta_t_, num_new + 1, profile_s, profile_v, profile_a);
+	}
+
+	AnchorCoordinates x_vals(ctx.anchor_x, ctx.anchor_x + 2);
+	AnchorCoordinates y_vals(ctx.anchor_y, ctx.anchor_y + 2);
+	double x_anchor, y_anchor;
+
+	if (candidate.spec.path_source == PathSource::Smoothed)
+	{
+		// every third station of the lateral profile, 15 m apart
+		const LateralProfile &profile = (*ctx.lateral_profiles)[lane];
+		for (size_t i = 3; i < profile.d.size() && !x_vals.full(); i += 3)
+		{
+			map.getXY(profile.s0 + i * profile.ds, profile.d[i], x_anchor, y_anchor);
+			x_vals.push_back(x_anchor);
+			y_vals.push_back(y_anchor);
+		}
+	}
+	else
+	{
+		double anchor = candidate.spec.anchor_distance;
+		double d = (lane + 0.5) * params.lane_width;
+		map.getXY(anchor + telemetry.car_s, d, x_anchor, y_anchor);
+		x_vals.push_back(x_anchor);
+		y_vals.push_back(y_anchor);
+		map.getXY(1.5 * anchor + telemetry.car_s, d, x_anchor, y_anchor);
+		x_vals.push_back(x_anchor);
+		y_vals.push_back(y_anchor);
+		map.getXY(3 * anchor + telemetry.car_s, d, x_anchor, y_anchor);
+		x_vals.push_back(x_anchor);
+		y_vals.push_back(y_anchor);
+	}
+
+	double ref_x = ctx.ref_x;
+	double ref_y = ctx.ref_y;
+	double ref_yaw = ctx.ref_yaw;
+
+	// Convert to local
+	for (unsigned int i = 0; i < x_vals.size(); i++)
+	{
+		double shift_x = x_vals[i] - ref_x;
+		double shift_y = y_vals[i] - ref_y;
+		x_vals[i] = shift_x * cos(0 - ref_yaw) - shift_y * sin(0 - ref_yaw);
+		y_vals[i] = shift_x * sin(0 - ref_yaw) + shift_y * cos(0 - ref_yaw);
+	}
+
+	// parametric in the chord length, points are placed by arc length so
+	// their spacing is v * dt on curves and lane changes too
+	// the table only covers the knots up to the reference point and the
+	// new points at the speed limit, with some margin
+	tk::parametric_spline &path = candidate.fit_cache->path;
+	double table_length = fabs(x_vals[1] - x_vals[0]) + 1.5 * num_new * params.v_max * delta_t_;
+	path.set_points(x_vals.data(), y_vals.data(), x_vals.size(), 0.5, &candidate.fit_cache->factorization, table_length);
+	double s_ref = path.knot_length(1);
+
+	for (int i = 0; i < ctx.number; i++)
+	{
+		next_x_vals.push_back(telemetry.previous_path_x[i]);
+		next_y_vals.push_back(telemetry.previous_path_y[i]);
+	}
+
+	// arc length from the reference point, of every new point
+	double s_add = 0;
+	double arc[kHorizon] = {};
+
+	for (int i = 0; i < num_new; i++)
+	{
+		if (s_curve)
+		{
+			v = std::max(profile_v[i], v_min);
+			v = std::min(v, map.profile().maxSpeedAt(ctx.ref_s + s_add, lane));
+		}
+		double displacement = v * delta_t_;
+		s_add += displacement;
+		arc[i] = s_ref + s_add;
+
+		// v reaches this point, a and jerk take it to the next one; the
+		// position follows from arc below
+		TrajectoryPoint state = {0.0, 0.0, 0.0, 0.0, v, a_end, 0.0};
+		if (s_curve)
+		{
+			state.a = profile_a[i];
+			state.jerk = (profile_a[i + 1] - profile_a[i]) / delta_t_;
+			candidate.states.push_back(state);
+			continue;
+		}
+		if (speed_plan)
+		{
+			desired_a_prev = (speed_plan->speedAt((i + 1) * delta_t_ + t_track) - v) / t_track;
+			desired_a_prev = std::max(std::min(desired_a_prev, a_max), a_min);
+		}
+		if ((a < desired_a_prev - 0.5) || (a > desired_a_prev + 0.5))
+		{
+			jerk = (desired_a_prev - a) / delta_t_;
+			jerk = std::min(jerk, jerk_max);
+			jerk = std::max(jerk, jerk_min);
+
+			a = a_end + jerk * delta_t_;
+			a = std::max(a, a_min);
+			a = std::min(a, a_max);
+
+			v = v + a * delta_t_;
+			a_end = a;
+			state.a = a;
+			state.jerk = jerk;
+		}
+		candidate.states.push_back(state);
+
+		v = std::max(v, v_min);
+		v = std::min(v, map.profile().maxSpeedAt(ctx.ref_s + s_add, lane));
+	}
+
+	// all new points in one pass over the path: position, heading and
+	// curvature from the spline derivatives, then back to map coordinates
+	double local_x[kHorizon];
+	double local_y[kHorizon];
+	candidate.heading.resize(num_new);
+	candidate.curvature.resize(num_new);
+	path.sample(arc, num_new, local_x, local_y, candidate.heading.data(), candidate.curvature.data());
+	double cos_yaw = cos(ref_yaw);
+	double sin_yaw = sin(ref_yaw);
+	for (int i = 0; i < num_new; i++)
+	{
+		double x_point = local_x[i] * cos_yaw - local_y[i] * sin_yaw + ref_x;
+		double y_point = local_x[i] * sin_yaw + local_y[i] * cos_yaw + ref_y;
+		next_x_vals.push_back(x_point);
+		next_y_vals.push_back(y_point);
+		candidate.states[i].x = x_point;
+		candidate.states[i].y = y_point;
+		candidate.heading[i] += ref_yaw;
+	}
+
+	validator_.validate(next_x_vals.data(), next_y_vals.data(), next_x_vals.size(), candidate.kinematics);
+}
+
+template <typename Params>
+double Planner::cost(const Params &params, const FrameContext &ctx, const Candidate &candidate) const
+{
+	const PathValues &x = candidate.x;
+	const PathValues &y = candidate.y;
+	const OccupancyGrid &occupancy = *ctx.occupancy;
+	double delta_t_ = 0.02;
+	double v_limit = params.v_max;
+	double cost = 0.0;
+
+	// collision with the predicted traffic, one check per grid time step;
+	// a later conflict is less bad than an early one. s is the arc length
+	// along the path, getFrenet's s jumps next to waypoints off the centre line
+	int stride = std::max(1, (int)(occupancy.dt() / delta_t_ + 0.5));
+	double s = ctx.telemetry->car_s;
+	double last_x = ctx.telemetry->car_x;
+	double last_y = ctx.telemetry->car_y;
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		s += distance(last_x, last_y, x[i], y[i]);
+		last_x = x[i];
+		last_y = y[i];
+		if ((int)i < ctx.number || i == 0 || (i - ctx.number) % stride != 0)
+		{
+			continue;
+		}
+		double t = (i + 1) * delta_t_;
+		int t_bin = (int)(t / occupancy.dt() + 0.5);
+		double s_map, d;
+		ctx.map->getFrenet(x[i], y[i], candidate.heading[i - ctx.number], s_map, d);
+		if (!occupancy.isFree((int)(d / params.lane_width), t_bin, s - 2.5, s + 2.5))
+		{
+			cost += 1e6 / (1.0 + t);
+			break;
+		}
+	}
+
+	// efficiency: speed at the end of the path against the speed limit
+	size_t n = x.size();
+	if (n >= 2)
+	{
+		double v_end = distance(x[n - 2], y[n - 2], x[n - 1], y[n - 1]) / delta_t_;
+		cost += 10.0 * std::max(0.0, v_limit - v_end) / v_limit;
+	}
+
+	// lane changes, and straying from the lane the behaviour layer chose
+	if (candidate.spec.lane != ctx.lane)
+	{
+		cost += 1.0;
+	}
+	cost += 5.0 * abs(candidate.spec.lane - ctx.target_lane);
+
+	// comfort: normal acceleration v^2 * curvature of the new points, the
+	// kept ones were rated when they were planned. Where the two meet the
+	// spline's heading need not match the kept path's, so the points there
+	// are rated by finite differences
+	double a_n_max = 0.0;
+	for (size_t i = 0; i < candidate.curvature.size(); i++)
+	{
+		double v = candidate.states[i].v;
+		a_n_max = std::max(a_n_max, v * v * fabs(candidate.curvature[i]));
+	}
+	for (size_t i = std::max(2, ctx.number); i < std::min(n, (size_t)ctx.number + 3); i++)
+	{
+		double vx = (x[i] - x[i - 1]) / delta_t_;
+		double vy = (y[i] - y[i - 1]) / delta_t_;
+		double ax = (x[i] - 2 * x[i - 1] + x[i - 2]) / (delta_t_ * delta_t_);
+		double ay = (y[i] - 2 * y[i - 1] + y[i - 2]) / (delta_t_ * delta_t_);
+		double speed = sqrt(vx * vx + vy * vy);
+		if (speed > 0.1)
+		{
+			a_n_max = std::max(a_n_max, fabs(vx * ay - vy * ax) / speed);
+		}
+	}
+	cost += 0.1 * a_n_max;
+	if (a_n_max > params.a_max)
+	{
+		cost += 100.0;
+	}
+
+	// beyond the simulator's limits: only taken if nothing else is left
+	if (!candidate.kinematics.ok())
+	{
+		cost += 1000.0;
+	}
+
+	return cost;
+}
+
+void Planner::emit(const FrameContext &ctx, const Candidate &candidate, TrajectoryBuffer &trajectory) const
+{
+	const Telemetry &telemetry = *ctx.telemetry;
+	double delta_t_ = 0.02;
+
+	trajectory.truncate(ctx.number);
+	if (trajectory.size() < ctx.number)
+	{
+		// out of sync, estimate the kept points from the previous path
+		trajectory.clear();
+		double s = telemetry.car_s;
+		double last_x = telemetry.car_x;
+		double last_y = telemetry.car_y;
+		for (int i = 0; i < ctx.number; i++)
+		{
+			double x = telemetry.previous_path_x[i];
+			double y = telemetry.previous_path_y[i];
+			double step = distance(last_x, last_y, x, y);
+			s += step;
+			TrajectoryPoint state = {x, y, s, telemetry.car_d, step / delta_t_, ctx.a_prev, 0.0};
+			trajectory.push(state);
+			last_x = x;
+			last_y = y;
+		}
+	}
+
+	double s = trajectory.empty() ? telemetry.car_s : trajectory[trajectory.size() - 1].s;
+	double last_x = trajectory.empty() ? telemetry.car_x : trajectory[trajectory.size() - 1].x;
+	double last_y = trajectory.empty() ? telemetry.car_y : trajectory[trajectory.size() - 1].y;
+	for (size_t i = 0; i < candidate.states.size(); i++)
+	{
+		TrajectoryPoint state = candidate.states[i];
+		s += distance(last_x, last_y, state.x, state.y);
+		state.s = s;
+		double s_map;
+		ctx.map->getFrenet(state.x, state.y, candidate.heading[i], s_map, state.d);
+		trajectory.push(state);
+		last_x = state.x;
+		last_y = state.y;
+	}
+}
@@ -0,0 +1,229 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "behavior.h"
+#include "inline_vector.h"
+#include "kinematic_validator.h"
+#include "occupancy_grid.h"
+#include "path_smoother.h"
+#include "planner_params.h"
+#include "prediction.h"
+#include "speed_planner.h"
+#include "thread_pool.h"
+#include "trajectory_buffer.h"
+#include "waypoint_map.h"
+
+// One telemetry message of the simulator
+struct Telemetry
+{
+	// Main car's localization Data, yaw in degrees and speed in mph
+	double car_x = 0.0;
+	double car_y = 0.0;
+	double car_s = 0.0;
+	double car_d = 0.0;
+	double car_yaw = 0.0;
+	double car_speed = 0.0;
+
+	// Previous path data given to the Planner
+	std::vector<double> previous_path_x;
+	std::vector<double> previous_path_y;
+
+	// Previous path's end s and d values
+	double end_path_s = 0.0;
+	double end_path_d = 0.0;
+
+	// Sensor Fusion Data, a list of all other cars on the same side of the road.
+	std::vector<std::vector<double>> sensor_fusion;
+};
+
+static_assert(kHorizon <= TrajectoryBuffer::kCapacity, "a path has to fit into the trajectory buffer");
+static_assert(kHorizon <= KinematicValidator::kMaxPoints, "the validator has to see the whole path");
+
+// spline anchors: the two that continue the previous path, and either three
+// at the candidate's anchor distance or the stations of a smoothed profile
+const int kMaxAnchors = 8;
+typedef InlineVector<double, kMaxAnchors> AnchorCoordinates;
+// one value per point of a path
+typedef InlineVector<double, kHorizon> PathValues;
+
+// Where a candidate's speed comes from: IDM behind the leader, an S-curve to
+// the desired speed, or the s-t speed plan of its lane
+enum class SpeedSource
+{
+	Idm,
+	SCurve,
+	StGraph
+};
+
+// Where a candidate's path shape comes from: a spline through anchors on the
+// lane centre, or through the lane's least-squares lateral profile
+enum class PathSource
+{
+	Anchors,
+	Smoothed
+};
+
+// Manoeuvre one candidate trajectory follows
+struct CandidateSpec
+{
+	int lane;
+	SpeedSource speed_source;
+	PathSource path_source;
+	// fraction of the lane speed limit used as desired speed
+	double speed_factor;
+	// distance ahead of the car of the first spline anchor, the other two
+	// are placed at 1.5 and 3 times that distance, unused by smoothed paths
+	double anchor_distance;
+};
+
+struct SplineFitCache;
+
+struct Candidate
+{
+	CandidateSpec spec;
+	PathValues x;
+	PathValues y;
+	// states of the points after the kept ones, s and d are only filled in
+	// for the chosen candidate
+	InlineVector<TrajectoryPoint, kHorizon> states;
+	// heading and signed curvature of the same points, from the path's
+	// derivatives
+	PathValues heading;
+	PathValues curvature;
+	// finite-difference speed, acceleration and jerk of x, y
+	KinematicReport kinematics;
+	double cost = 0.0;
+	bool evaluated = false;
+	// spline factorization of the candidate in the same slot last frame
+	SplineFitCache *fit_cache = nullptr;
+};
+
+// Everything candidates share within one frame
+struct FrameContext
+{
+	const Telemetry *telemetry;
+	const WaypointMap *map;
+	const TrafficPrediction *prediction;
+	const OccupancyGrid *occupancy;
+
+	int lane;
+	double car_v;
+	// first point of the new trajectory and the heading there
+	double ref_x;
+	double ref_y;
+	double ref_yaw;
+	double ref_s;
+	double v_prev;
+	double a_prev;
+	// points taken over from the previous path
+	int number;
+	// the two spline anchors that continue the previous path
+	double anchor_x[2];
+	double anchor_y[2];
+	// behaviour layer output, and the IDM gap and speed difference it saw
+	// in its target lane at t_check
+	int target_lane;
+	double target_gap;
+	double target_delta_v;
+	double t_check;
+	// s-t speed plan from the first new point on, per lane
+	const std::vector<SpeedProfile> *speed_profiles;
+	// smoothed lateral path from ref_s on, per lane
+	const std::vector<LateralProfile> *lateral_profiles;
+	// candidates not started by then are skipped
+	std::chrono::steady_clock::time_point deadline;
+};
+
+// Planning counters since start, a deadline hit is a frame in which some
+// candidates were skipped
+struct PlannerStats
+{
+	unsigned long frames = 0;
+	unsigned long deadline_hits = 0;
+	unsigned long candidates_evaluated = 0;
+	unsigned long candidates_skipped = 0;
+	// spline fits, and those that reused the slot's last decomposition
+	unsigned long spline_fits = 0;
+	unsigned long spline_fits_reused = 0;
+	// candidates beyond the kinematic limits, and frames that still sent such
+	// a path because nothing better was found
+	unsigned long candidates_rejected = 0;
+	unsigned long kinematic_violations = 0;
+	// lane changes the behaviour layer started
+	unsigned long lane_changes = 0;
+};
+
+class Planner
+{
+public:
+	// num_threads workers evaluate candidates in parallel (0: all inline);
+	// candidates not started within frame_budget_ms are skipped, the
+	// keep-lane fallback is always evaluated
+	explicit Planner(int num_threads = 0, double frame_budget_ms = 10.0);
+	~Planner();
+
+	// path made up of (x,y) points that the car will visit sequentially every .02 seconds.
+	// trajectory holds the states of the last path sent on this connection,
+	// the new path continues from them and replaces them
+	void plan(const Telemetry &telemetry, const WaypointMap &map, TrajectoryBuffer &trajectory,
+			  std::vector<double> &next_x_vals, std::vector<double> &next_y_vals);
+
+	// tuning constants bound at runtime, in place of StaticPlannerParams
+	void setParams(const PlannerParams &params);
+	bool hasRuntimeParams() const { return params_ != nullptr; }
+
+	int numCandidates() const { return num_candidates_; }
+	int numThreads() const { return pool_.size(); }
+	// points of the previous path the last plan starts with, unchanged
+	int keptPoints() const { return kept_points_; }
+
+	double frameBudget() const { return frame_budget_ms_; }
+	void setFrameBudget(double frame_budget_ms) { frame_budget_ms_ = frame_budget_ms; }
+	const PlannerStats &stats() const { return stats_; }
+
+private:
+	template <typename Params>
+	void planFrame(const Params &params, const Telemetry &telemetry, const WaypointMap &map, TrajectoryBuffer &trajectory,
+				   std::vector<double> &next_x_vals, std::vector<double> &next_y_vals);
+	void buildCandidates(const FrameContext &ctx);
+	// generates and scores candidate with the bound params
+	void evaluate(const FrameContext &ctx, Candidate &candidate) const;
+	template <typename Params>
+	void generate(const Params &params, const FrameContext &ctx, Candidate &candidate) const;
+	template <typename Params>
+	double cost(const Params &params, const FrameContext &ctx, const Candidate &candidate) const;
+	// replaces everything after the kept points of trajectory by candidate
+	void emit(const FrameContext &ctx, const Candidate &candidate, TrajectoryBuffer &trajectory) const;
+
+	// null: StaticPlannerParams
+	std::unique_ptr<PlannerParams> params_;
+	BehaviorState behavior_;
+	int kept_points_ = 0;
+	double frame_budget_ms_;
+	PlannerStats stats_;
+
+	// per-vehicle predictions, reused from frame to frame
+	TrafficPrediction prediction_;
+	// (lane, t, s) occupancy of that prediction
+	OccupancyGrid occupancy_;
+	KinematicValidator validator_;
+	SpeedPlanner speed_planner_;
+	std::vector<SpeedProfile> speed_profiles_;
+	// each lane's profile is the warm start of the next frame's
+	PathSmoother path_smoother_;
+	std::vector<LateralProfile> lateral_profiles_;
+
+	// the first num_candidates_ are this frame's
+	std::vector<Candidate> candidates_;
+	size_t num_candidates_ = 0;
+	// one per candidate slot, the same slot mostly holds the same kind of
+	// candidate from frame to frame
+	std::vector<std::unique_ptr<SplineFitCache>> fit_caches_;
+	ThreadPool pool_;
+};
+
+#endif /* PLANNER_H */
@@ -0,0 +1,116 @@
+#include "planner_params.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "json.hpp"
+#include "waypoint_map.h"
+
+using namespace std;
+using json = nlohmann::json;
+
+constexpr double StaticPlannerParams::a_max;
+constexpr double StaticPlannerParams::jerk_max;
+constexpr double StaticPlannerParams::v_max;
+constexpr double StaticPlannerParams::v_min;
+constexpr double StaticPlannerParams::s_0;
+constexpr double StaticPlannerParams::t_gap;
+constexpr double StaticPlannerParams::a_acc;
+constexpr double StaticPlannerParams::a_dec;
+constexpr double StaticPlannerParams::a_comfort;
+constexpr double StaticPlannerParams::jerk_comfort;
+constexpr int StaticPlannerParams::kept_points;
+constexpr double StaticPlannerParams::lane_width;
+
+// value of key in object, if it is there and a positive number
+static bool readPositive(const json &object, const char *key, double &value)
+{
+	json::const_iterator it = object.find(key);
+	if (it == object.end())
+	{
+		return true;
+	}
+	if (!it->is_number() || it->get<double>() <= 0.0)
+	{
+		cerr << "planner params: " << key << " has to be a positive number" << endl;
+		return false;
+	}
+	value = it->get<double>();
+	return true;
+}
+
+bool PlannerParams::fromFile(const string &path, PlannerParams &params)
+{
+	ifstream in(path);
+	if (!in)
+	{
+		cerr << "planner params: cannot open " << path << endl;
+		return false;
+	}
+	json object;
+	try
+	{
+		object = json::parse(in);
+	}
+	catch (const exception &e)
+	{
+		cerr << "planner params: " << path << ": " << e.what() << endl;
+		return false;
+	}
+	if (!object.is_object())
+	{
+		cerr << "planner params: " << path << " does not hold an object" << endl;
+		return false;
+	}
+	static const char *names[] = {"a_max", "jerk_max", "v_max", "v_min", "s_0", "t_gap", "a_acc",
+								  "a_dec", "a_comfort", "jerk_comfort", "kept_points", "lane_width"};
+	for (json::const_iterator it = object.begin(); it != object.end(); ++it)
+	{
+		if (find(begin(names), end(names), it.key()) == end(names))
+		{
+			cerr << "planner params: unknown parameter " << it.key() << endl;
+			return false;
+		}
+	}
+
+	PlannerParams read = params;
+	double kept_points = read.kept_points;
+	bool ok = readPositive(object, "a_max", read.a_max) && readPositive(object, "jerk_max", read.jerk_max) &&
+			  readPositive(object, "v_max", read.v_max) && readPositive(object, "v_min", read.v_min) &&
+			  readPositive(object, "s_0", read.s_0) && readPositive(object, "t_gap", read.t_gap) &&
+			  readPositive(object, "a_acc", read.a_acc) && readPositive(object, "a_dec", read.a_dec) &&
+			  readPositive(object, "a_comfort", read.a_comfort) && readPositive(object, "jerk_comfort", read.jerk_comfort) &&
+			  readPositive(object, "kept_points", kept_points) && readPositive(object, "lane_width", read.lane_width);
+	if (!ok)
+	{
+		return false;
+	}
+	read.kept_points = (int)kept_points;
+	if (read.kept_points != kept_points || read.kept_points < 2 || read.kept_points >= kHorizon)
+	{
+		cerr << "planner params: kept_points has to be a whole number in [2, " << kHorizon << ")" << endl;
+		return false;
+	}
+	if (read.v_min >= read.v_max)
+	{
+		cerr << "planner params: v_min has to be below v_max" << endl;
+		return false;
+	}
+	// the map's speed profile caps the speed, and the map, prediction and
+	// behaviour layer look lanes up with the map's lane width
+	MapBuildParams map_params;
+	if (read.v_max > map_params.v_max)
+	{
+		cerr << "planner params: v_max cannot be above the map's speed limit, " << map_params.v_max << " m/s" << endl;
+		return false;
+	}
+	if (read.lane_width != map_params.lane_width)
+	{
+		cerr << "planner params: lane_width has to be the map's, " << map_params.lane_width << " m" << endl;
+		return false;
+	}
+	params = read;
+	return true;
+}
@@ -0,0 +1,66 @@
+#ifndef PLANNER_PARAMS_H
+#define PLANNER_PARAMS_H
+
+#include <string>
+
+// Points of a planned path, the ones kept from the previous path included.
+// It sizes the planner's path buffers, so it is only set at compile time
+// (cmake -DPLANNER_HORIZON=<points>)
+#ifndef PLANNER_HORIZON
+#define PLANNER_HORIZON 50
+#endif
+const int kHorizon = PLANNER_HORIZON;
+
+// Tuning constants of trajectory generation and scoring, bound at runtime,
+// e.g. read from a file. StaticPlannerParams has the same members as
+// compile-time constants; the planner's per-frame code is a template over
+// either, so with the static ones it folds them into the code.
+struct PlannerParams
+{
+	// longitudinal limits of the generated paths; v_max at most the map's
+	// speed limit, which caps its speed profile
+	double a_max = 9.0;
+	double jerk_max = 9.0;
+	double v_max = 48.0 * 0.44704;
+	double v_min = 1.0;
+	// IDM: minimum gap, time gap, maximum acceleration and comfortable
+	// deceleration
+	double s_0 = 20.0;
+	double t_gap = 1.5;
+	double a_acc = 9.0;
+	double a_dec = 9.0;
+	// S-curve candidates accelerate within these
+	double a_comfort = 5.0;
+	double jerk_comfort = 5.0;
+	// points of the previous path every plan starts with
+	int kept_points = 10;
+	// lane geometry of the planner's own lane lookups, only the map's: the
+	// map, prediction and behaviour layer use it too
+	double lane_width = 4.0;
+
+	// Overrides the members named in the JSON object in path. False when the
+	// file cannot be parsed or a value is out of range, params is unchanged
+	// then.
+	static bool fromFile(const std::string &path, PlannerParams &params);
+};
+
+struct StaticPlannerParams
+{
+	static constexpr double a_max = 9.0;
+	static constexpr double jerk_max = 9.0;
+	static constexpr double v_max = 48.0 * 0.44704;
+	static constexpr double v_min = 1.0;
+	static constexpr double s_0 = 20.0;
+	static constexpr double t_gap = 1.5;
+	static constexpr double a_acc = 9.0;
+	static constexpr double a_dec = 9.0;
+	static constexpr double a_comfort = 5.0;
+	static constexpr double jerk_comfort = 5.0;
+	static constexpr int kept_points = 10;
+	static constexpr double lane_width = 4.0;
+};
+
+static_assert(StaticPlannerParams::kept_points > 1 && StaticPlannerParams::kept_points < kHorizon,
+			  "the kept points have to leave room for new ones");
+
+#endif /* PLANNER_PARAMS_H */
@@ -0,0 +1,174 @@
+#include "planning_pipeline.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+void *PlanningPipeline::operator new(size_t size)
+{
+	void *p = nullptr;
+	if (posix_memalign(&p, alignof(PlanningPipeline), size) != 0)
+	{
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void PlanningPipeline::operator delete(void *p)
+{
+	free(p);
+}
+
+PlanningPipeline::PlanningPipeline(Planner &planner, const MapStore &map_store)
+	: planner_(planner), map_store_(map_store), stop_(false),
+	  submitted_(0), dropped_(0), coalesced_(0), planned_(0), unstitched_(0)
+{
+	thread_ = thread(&PlanningPipeline::run, this);
+}
+
+PlanningPipeline::~PlanningPipeline()
+{
+	stop_.store(true);
+	wake_.notify_one();
+	thread_.join();
+}
+
+void PlanningPipeline::process(const Telemetry &telemetry, vector<double> &next_x_vals, vector<double> &next_y_vals)
+{
+	reply(telemetry, next_x_vals, next_y_vals);
+
+	Telemetry frame = telemetry;
+	frame.previous_path_x = next_x_vals;
+	frame.previous_path_y = next_y_vals;
+	if (!frames_.push(frame))
+	{
+		dropped_.fetch_add(1);
+		return;
+	}
+	submitted_.fetch_add(1);
+	wake_.notify_one();
+}
+
+void PlanningPipeline::reply(const Telemetry &telemetry, vector<double> &next_x_vals, vector<double> &next_y_vals)
+{
+	const vector<double> &previous_path_x = telemetry.previous_path_x;
+	const vector<double> &previous_path_y = telemetry.previous_path_y;
+	// the simulator echoes the points back through JSON
+	const double tolerance = 1e-3;
+
+	next_x_vals = previous_path_x;
+	next_y_vals = previous_path_y;
+
+	lock_guard<mutex> lock(plan_mutex_);
+	if (!has_plan_)
+	{
+		return;
+	}
+	const Plan &plan = plans_[front_];
+
+	// nothing left of the last path: only a plan made from a standstill at
+	// the end of a path starts where the car is
+	if (previous_path_x.empty())
+	{
+		if (plan.kept == 0)
+		{
+			next_x_vals = plan.x;
+			next_y_vals = plan.y;
+		}
+		else
+		{
+			unstitched_.fetch_add(1);
+		}
+		return;
+	}
+
+	// the point the car drives to next must be one the plan kept, and the
+	// rest of those must still lie ahead of it unchanged
+	int next = -1;
+	for (int i = 0; i < plan.kept; i++)
+	{
+		if (fabs(plan.x[i] - previous_path_x[0]) < tolerance && fabs(plan.y[i] - previous_path_y[0]) < tolerance)
+		{
+			next = i;
+			break;
+		}
+	}
+	bool matches = next >= 0;
+	for (int i = next + 1; matches && i < plan.kept; i++)
+	{
+		size_t k = i - next;
+		matches = k < previous_path_x.size() && fabs(plan.x[i] - previous_path_x[k]) < tolerance &&
+				  fabs(plan.y[i] - previous_path_y[k]) < tolerance;
+	}
+
+	if (!matches)
+	{
+		// the plan was made for a path that has since changed, keep driving
+		// the one sent last; the plan for it is on its way
+		unstitched_.fetch_add(1);
+		return;
+	}
+	next_x_vals.assign(plan.x.begin() + next, plan.x.end());
+	next_y_vals.assign(plan.y.begin() + next, plan.y.end());
+}
+
+PipelineStats PlanningPipeline::stats() const
+{
+	PipelineStats stats;
+	stats.submitted = submitted_.load();
+	stats.dropped = dropped_.load();
+	stats.coalesced = coalesced_.load();
+	stats.planned = planned_.load();
+	stats.unstitched = unstitched_.load();
+	return stats;
+}
+
+PlannerStats PlanningPipeline::plannerStats() const
+{
+	lock_guard<mutex> lock(plan_mutex_);
+	return plans_[front_].stats;
+}
+
+void PlanningPipeline::run()
+{
+	Telemetry telemetry;
+	vector<double> next_x_vals;
+	vector<double> next_y_vals;
+	while (!stop_.load())
+	{
+		if (!frames_.pop(telemetry))
+		{
+			// the timeout covers a notify between pop and wait
+			unique_lock<mutex> lock(wake_mutex_);
+			wake_.wait_for(lock, chrono::milliseconds(1));
+			continue;
+		}
+		// frames that queued up while planning are stale, plan the newest
+		while (frames_.pop(telemetry))
+		{
+			coalesced_.fetch_add(1);
+		}
+
+		{
+			MapStore::Snapshot waypoint_map = map_store_.acquire();
+			planner_.plan(telemetry, *waypoint_map, trajectory_, next_x_vals, next_y_vals);
+		}
+
+		// only this thread writes the back buffer, the network thread reads
+		// the front one under plan_mutex_
+		Plan &back = plans_[1 - front_];
+		back.x.swap(next_x_vals);
+		back.y.swap(next_y_vals);
+		back.kept = planner_.keptPoints();
+		back.stats = planner_.stats();
+		{
+			lock_guard<mutex> lock(plan_mutex_);
+			front_ = 1 - front_;
+			has_plan_ = true;
+		}
+		planned_.fetch_add(1);
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef PLANNING_PIPELINE_H
+#define PLANNING_PIPELINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "map_store.h"
+#include "planner.h"
+#include "spsc_queue.h"
+
+struct PipelineStats
+{
+	// telemetry frames handed to the planner thread, and those dropped
+	// because its queue was full
+	unsigned long submitted = 0;
+	unsigned long dropped = 0;
+	// frames skipped by the planner thread because a newer one was queued
+	unsigned long coalesced = 0;
+	// plans completed by the planner thread
+	unsigned long planned = 0;
+	// replies that resent the previous path because the latest plan started
+	// from a different one
+	unsigned long unstitched = 0;
+};
+
+// Runs a Planner on its own thread so the network thread only parses,
+// queues and replies. Frames go to the planner over a lock-free SPSC queue,
+// plans come back through a double buffer and every reply is the freshest
+// completed plan continued from the newest previous path.
+//
+// A plan can only be spliced in while the points it kept from its previous
+// path are still ahead of the car unchanged, so each frame is planned on the
+// path actually sent for it.
+class PlanningPipeline
+{
+public:
+	PlanningPipeline(Planner &planner, const MapStore &map_store);
+	~PlanningPipeline();
+
+	PlanningPipeline(const PlanningPipeline &) = delete;
+	PlanningPipeline &operator=(const PlanningPipeline &) = delete;
+
+	// the queue's cache-line aligned members need more than the 16 bytes a
+	// plain new guarantees before C++17
+	static void *operator new(size_t size);
+	static void operator delete(void *p);
+
+	// network thread: fills the path to send for telemetry from the latest
+	// plan, then queues telemetry for planning on top of that path
+	void process(const Telemetry &telemetry, std::vector<double> &next_x_vals, std::vector<double> &next_y_vals);
+
+	PipelineStats stats() const;
+	// the planner's counters as of its last completed plan
+	PlannerStats plannerStats() const;
+
+private:
+	struct Plan
+	{
+		std::vector<double> x;
+		std::vector<double> y;
+		// leading points copied from the previous path it was planned on
+		int kept;
+		PlannerStats stats;
+	};
+
+	void reply(const Telemetry &telemetry, std::vector<double> &next_x_vals, std::vector<double> &next_y_vals);
+	void run();
+
+	Planner &planner_;
+	const MapStore &map_store_;
+	// states of the last plan, planner thread only
+	TrajectoryBuffer trajectory_;
+
+	SpscQueue<Telemetry, 8> frames_;
+	std::mutex wake_mutex_;
+	std::condition_variable wake_;
+	std::atomic<bool> stop_;
+
+	// plans_[front_] is the latest completed plan, the planner thread only
+	// writes the other one and swaps under plan_mutex_
+	Plan plans_[2];
+	int front_ = 0;
+	bool has_plan_ = false;
+	mutable std::mutex plan_mutex_;
+
+	std::atomic<unsigned long> submitted_;
+	std::atomic<unsigned long> dropped_;
+	std::atomic<unsigned long> coalesced_;
+	std::atomic<unsigned long> planned_;
+	std::atomic<unsigned long> unstitched_;
+
+	std::thread thread_;
+};
+
+#endif /* PLANNING_PIPELINE_H */
@@ -0,0 +1,50 @@
+#include "prediction.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+TrafficPrediction::TrafficPrediction(double dt, int steps)
+	: dt_(dt), times_(Eigen::ArrayXd::LinSpaced(steps, 0.0, dt * (steps - 1))), s_(0, steps)
+{
+}
+
+void TrafficPrediction::update(const vector<vector<double>> &sensor_fusion)
+{
+	int n = sensor_fusion.size();
+	// no reallocation while the number of vehicles stays the same
+	id_.resize(n);
+	d_.resize(n);
+	speed_.resize(n);
+	s0_.resize(n);
+	s_.resize(n, times_.size());
+
+	Eigen::ArrayXd vx(n);
+	Eigen::ArrayXd vy(n);
+	for (int i = 0; i < n; i++)
+	{
+		id_[i] = sensor_fusion[i][0];
+		vx[i] = sensor_fusion[i][3];
+		vy[i] = sensor_fusion[i][4];
+		s0_[i] = sensor_fusion[i][5];
+		d_[i] = sensor_fusion[i][6];
+	}
+	speed_ = (vx * vx + vy * vy).sqrt();
+
+	// s(i, k) = s0(i) + speed(i) * t(k), as one vectorized outer product
+	s_.matrix().noalias() = speed_.matrix() * times_.matrix().transpose();
+	s_.colwise() += s0_;
+}
+
+double TrafficPrediction::sAt(int vehicle, double t) const
+{
+	double k = max(0.0, min(t / dt_, (double)(s_.cols() - 1)));
+	int k0 = min((int)k, (int)s_.cols() - 2);
+	if (k0 < 0)
+	{
+		return s_(vehicle, 0);
+	}
+	double w = k - k0;
+	return s_(vehicle, k0) + w * (s_(vehicle, k0 + 1) - s_(vehicle, k0));
+}
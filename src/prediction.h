@@ -0,0 +1,49 @@
+#ifndef PREDICTION_H
+#define PREDICTION_H
+
+#include <vector>
+
+#include "Eigen-3.3/Eigen/Core"
+
+// Constant-speed prediction of every sensor fusion vehicle along s.
+// update() runs once per frame and fills a contiguous vehicle x time table,
+// every check afterwards only reads from it.
+class TrafficPrediction
+{
+public:
+	// steps samples at t = 0, dt, ..., (steps - 1) * dt
+	TrafficPrediction(double dt = 0.1, int steps = 51);
+
+	// sensor_fusion rows are [id, x, y, vx, vy, s, d]
+	void update(const std::vector<std::vector<double>> &sensor_fusion);
+
+	int numVehicles() const { return s_.rows(); }
+	int numSteps() const { return s_.cols(); }
+	double dt() const { return dt_; }
+	double horizon() const { return dt_ * (s_.cols() - 1); }
+
+	int id(int vehicle) const { return id_[vehicle]; }
+	double d(int vehicle) const { return d_[vehicle]; }
+	double speed(int vehicle) const { return speed_[vehicle]; }
+	bool inLane(int vehicle, int lane) const { return (d_[vehicle] < (2 + 4 * lane + 2)) && (d_[vehicle] > (2 + 4 * lane - 2)); }
+
+	// predicted s at sample step
+	double s(int vehicle, int step) const { return s_(vehicle, step); }
+	// predicted s at time t, linear between samples and clamped to the horizon
+	double sAt(int vehicle, double t) const;
+	// all predicted s of one vehicle, numSteps() contiguous values
+	const double *row(int vehicle) const { return s_.data() + vehicle * s_.cols(); }
+
+private:
+	typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Table;
+
+	double dt_;
+	Eigen::ArrayXd times_;
+	std::vector<int> id_;
+	Eigen::ArrayXd d_;
+	Eigen::ArrayXd speed_;
+	Eigen::ArrayXd s0_;
+	Table s_;
+};
+
+#endif /* PREDICTION_H */
@@ -0,0 +1,145 @@
+#include "road_profile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+// Signed curvature of the circle through three points (Menger curvature)
+static double threePointCurvature(double ax, double ay, double bx, double by, double cx, double cy)
+{
+	double cross = (bx - ax) * (cy - by) - (by - ay) * (cx - bx);
+	double ab = sqrt((bx - ax) * (bx - ax) + (by - ay) * (by - ay));
+	double bc = sqrt((cx - bx) * (cx - bx) + (cy - by) * (cy - by));
+	double ac = sqrt((cx - ax) * (cx - ax) + (cy - ay) * (cy - ay));
+	double denom = ab * bc * ac;
+	if (denom == 0.0)
+	{
+		return 0.0;
+	}
+	return 2.0 * cross / denom;
+}
+
+RoadProfile::RoadProfile(const vector<double> &maps_x, const vector<double> &maps_y, const vector<double> &maps_s,
+						 double max_s, double v_max, double a_lat_max, double a_brake,
+						 int num_lanes, double lane_width, double ds)
+	: ds_(ds), inv_ds_(1.0 / ds), max_s_(max_s), num_lanes_(num_lanes)
+{
+	int num_wp = maps_x.size();
+	if (num_wp < 3 || max_s <= 0.0)
+	{
+		return;
+	}
+
+	// curvature at every waypoint, the track is a closed loop
+	vector<double> wp_kappa(num_wp);
+	for (int i = 0; i < num_wp; i++)
+	{
+		int prev = (i + num_wp - 1) % num_wp;
+		int next = (i + 1) % num_wp;
+		wp_kappa[i] = threePointCurvature(maps_x[prev], maps_y[prev], maps_x[i], maps_y[i], maps_x[next], maps_y[next]);
+	}
+
+	// one block holding kappa, dkappa and the per-lane speed limits
+	int n = (int)ceil(max_s * inv_ds_);
+	shared_ptr<vector<double> > tables = make_shared<vector<double> >((2 + num_lanes) * n);
+	double *kappa = tables->data();
+	double *dkappa = kappa + n;
+	double *v_limit = dkappa + n;
+
+	// resample on the uniform grid by linear interpolation between waypoints
+	int wp = 0;
+	for (int i = 0; i < n; i++)
+	{
+		double s = i * ds_;
+		while (wp < num_wp - 1 && maps_s[wp + 1] <= s)
+		{
+			wp++;
+		}
+		int next_wp = (wp + 1) % num_wp;
+		double s0 = maps_s[wp];
+		double s1 = (next_wp == 0) ? max_s : maps_s[next_wp];
+		double t = (s1 > s0) ? (s - s0) / (s1 - s0) : 0.0;
+		kappa[i] = wp_kappa[wp] + t * (wp_kappa[next_wp] - wp_kappa[wp]);
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		dkappa[i] = (kappa[(i + 1) % n] - kappa[(i + n - 1) % n]) * 0.5 * inv_ds_;
+	}
+
+	// lateral acceleration limit per lane; d grows to the right of the reference
+	// line so the offset curve has curvature kappa / (1 + kappa * d)
+	for (int lane = 0; lane < num_lanes; lane++)
+	{
+		double d = lane_width * (lane + 0.5);
+		double *v_lane = &v_limit[lane * n];
+		for (int i = 0; i < n; i++)
+		{
+			double k = fabs(kappa[i] / (1.0 + kappa[i] * d));
+			v_lane[i] = (k > 0.0) ? min(v_max, sqrt(a_lat_max / k)) : v_max;
+		}
+
+		// backward pass so every limit can be reached from the samples behind it
+		// by braking at a_brake; two laps settle the wrap-around
+		for (int pass = 0; pass < 2 * n; pass++)
+		{
+			int i = n - 1 - (pass % n);
+			double reachable = sqrt(v_lane[(i + 1) % n] * v_lane[(i + 1) % n] + 2.0 * a_brake * ds_);
+			v_lane[i] = min(v_lane[i], reachable);
+		}
+	}
+
+	storage_ = tables;
+	kappa_ = kappa;
+	dkappa_ = dkappa;
+	v_limit_ = v_limit;
+	size_ = n;
+}
+
+RoadProfile::RoadProfile(shared_ptr<const void> storage, const double *kappa, const double *dkappa, const double *v_limit,
+						 int size, int num_lanes, double max_s, double ds)
+	: ds_(ds), inv_ds_(1.0 / ds), max_s_(max_s), num_lanes_(num_lanes), size_(size),
+	  storage_(storage), kappa_(kappa), dkappa_(dkappa), v_limit_(v_limit)
+{
+}
+
+int RoadProfile::index(double s) const
+{
+	s = fmod(s, max_s_);
+	if (s < 0)
+	{
+		s += max_s_;
+	}
+	int i = (int)(s * inv_ds_);
+	return min(i, size_ - 1);
+}
+
+double RoadProfile::curvatureAt(double s) const
+{
+	if (size_ == 0)
+	{
+		return 0.0;
+	}
+	return kappa_[index(s)];
+}
+
+double RoadProfile::curvatureRateAt(double s) const
+{
+	if (size_ == 0)
+	{
+		return 0.0;
+	}
+	return dkappa_[index(s)];
+}
+
+double RoadProfile::maxSpeedAt(double s, int lane) const
+{
+	if (size_ == 0)
+	{
+		return numeric_limits<double>::infinity();
+	}
+	lane = max(0, min(lane, num_lanes_ - 1));
+	return v_limit_[lane * size_ + index(s)];
+}
@@ -0,0 +1,54 @@
+#ifndef ROAD_PROFILE_H
+#define ROAD_PROFILE_H
+
+#include <memory>
+#include <vector>
+
+// Curvature profile of the track sampled on a uniform s grid.
+// Built once from the waypoint map; every query is a single table lookup.
+// The tables are either owned or borrowed from storage that outlives the
+// profile (an embedded map), copies share them.
+class RoadProfile
+{
+public:
+	RoadProfile() {}
+	RoadProfile(const std::vector<double> &maps_x, const std::vector<double> &maps_y, const std::vector<double> &maps_s,
+				double max_s, double v_max, double a_lat_max = 3.0, double a_brake = 2.0,
+				int num_lanes = 3, double lane_width = 4.0, double ds = 1.0);
+	// view over precomputed tables of size samples (num_lanes * size for v_limit)
+	RoadProfile(std::shared_ptr<const void> storage, const double *kappa, const double *dkappa, const double *v_limit,
+				int size, int num_lanes, double max_s, double ds);
+
+	// signed curvature of the reference line (1/m, positive turning left)
+	double curvatureAt(double s) const;
+	// derivative of the curvature along s (1/m^2)
+	double curvatureRateAt(double s) const;
+	// highest speed (m/s) that keeps lateral acceleration below a_lat_max in the
+	// given lane, lowered ahead of curves so it can be reached with a_brake
+	double maxSpeedAt(double s, int lane) const;
+
+	int size() const { return size_; }
+	int numLanes() const { return num_lanes_; }
+	double ds() const { return ds_; }
+	double maxS() const { return max_s_; }
+	const double *curvatureTable() const { return kappa_; }
+	const double *curvatureRateTable() const { return dkappa_; }
+	// lane-major: speedLimitTable()[lane * size() + i]
+	const double *speedLimitTable() const { return v_limit_; }
+
+private:
+	int index(double s) const;
+
+	double ds_ = 1.0;
+	double inv_ds_ = 1.0;
+	double max_s_ = 0.0;
+	int num_lanes_ = 0;
+	int size_ = 0;
+
+	std::shared_ptr<const void> storage_;
+	const double *kappa_ = nullptr;
+	const double *dkappa_ = nullptr;
+	const double *v_limit_ = nullptr;
+};
+
+#endif /* ROAD_PROFILE_H */
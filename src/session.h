@@ -0,0 +1,68 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <utility>
+
+#include "planner.h"
+#include "trajectory_buffer.h"
+
+// Per-connection state, attached to the simulator's websocket with
+// setUserData on connection and freed on disconnection
+struct Session
+{
+	// frames in a row dropped for a newer one, after which the newest is
+	// planned even if more keep arriving
+	static const int kMaxSkipped = 4;
+
+	// telemetry frames received, and those dropped for a newer one before
+	// they were planned
+	unsigned long frames = 0;
+	unsigned long coalesced = 0;
+
+	// states of the points sent and not driven yet
+	TrajectoryBuffer trajectory;
+
+	// listed among the connections waiting for the end of the loop
+	// iteration, at most once
+	bool queued = false;
+
+	// Frames queued by the simulator while the planner was busy arrive back
+	// to back. Each is held here until the event loop has delivered them
+	// all, an older one not planned yet is dropped for the newer.
+	void receive(Telemetry &telemetry)
+	{
+		frames++;
+		if (has_pending_)
+		{
+			coalesced++;
+			skipped_++;
+		}
+		// swapped, so both keep their vectors' capacity
+		std::swap(pending_, telemetry);
+		has_pending_ = true;
+	}
+
+	bool hasPending() const { return has_pending_; }
+	// kMaxSkipped frames dropped since the last planned one
+	bool mustPlan() const { return has_pending_ && skipped_ >= kMaxSkipped; }
+
+	// moves the held frame to telemetry, false if there is none
+	bool takePending(Telemetry &telemetry)
+	{
+		if (!has_pending_)
+		{
+			return false;
+		}
+		std::swap(pending_, telemetry);
+		has_pending_ = false;
+		skipped_ = 0;
+		return true;
+	}
+
+private:
+	Telemetry pending_;
+	bool has_pending_ = false;
+	int skipped_ = 0;
+};
+
+#endif /* SESSION_H */
@@ -0,0 +1,159 @@
+#include "speed_planner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace
+{
+const double kInfinity = numeric_limits<double>::infinity();
+} // namespace
+
+double SpeedProfile::speedAt(double t) const
+{
+	int n = v.size();
+	if (n == 0)
+	{
+		return 0.0;
+	}
+	// v[k] is taken as the speed in the middle of step k
+	double k = t / dt - 0.5;
+	if (k <= 0.0)
+	{
+		return v[0];
+	}
+	if (k >= n - 1)
+	{
+		return v[n - 1];
+	}
+	int k0 = (int)k;
+	return v[k0] + (k - k0) * (v[k0 + 1] - v[k0]);
+}
+
+SpeedPlanner::SpeedPlanner(const SpeedPlannerParams &params)
+	: params_(params)
+{
+}
+
+bool SpeedPlanner::plan(double s, double v0, double a0, double v_limit, int lane, double t0,
+						const TrafficPrediction &prediction, SpeedProfile &profile)
+{
+	const SpeedPlannerParams &p = params_;
+	int steps = p.steps;
+	double dt = p.dt;
+	int bins = (int)(v_limit * dt * steps / p.s_res) + 2;
+
+	profile.feasible = false;
+	profile.dt = dt;
+	profile.v.clear();
+
+	// obstacles: the closest car ahead in the lane bounds s at every step;
+	// cars alongside block the start, cars behind are left to the cost check
+	s_limit_.assign(steps + 1, bins - 1);
+	leader_rear_.assign(steps + 1, kInfinity);
+	leader_speed_.assign(steps + 1, 0.0);
+	for (int i = 0; i < prediction.numVehicles(); i++)
+	{
+		if (!prediction.inLane(i, lane))
+		{
+			continue;
+		}
+		double gap0 = prediction.sAt(i, t0) - s;
+		if (gap0 < -p.car_length)
+		{
+			continue;
+		}
+		if (gap0 < p.car_length + p.s_min)
+		{
+			return false;
+		}
+		for (int k = 1; k <= steps; k++)
+		{
+			// constant speed, beyond the prediction table's horizon too
+			double rear = gap0 + prediction.speed(i) * k * dt - p.car_length;
+			if (rear < leader_rear_[k])
+			{
+				leader_rear_[k] = rear;
+				leader_speed_[k] = prediction.speed(i);
+				s_limit_[k] = min(bins - 1, (int)floor((rear - p.s_min) / p.s_res));
+			}
+		}
+	}
+
+	// step-major table, only grown
+	size_t size = (size_t)(steps + 1) * bins;
+	if (cells_.size() < size)
+	{
+		cells_.resize(size);
+	}
+	Cell empty = {kInfinity, 0.0, 0.0, -1};
+	fill(cells_.begin(), cells_.begin() + size, empty);
+	Cell start = {0.0, v0, a0, -1};
+	cells_[0] = start;
+
+	int last = 0;
+	for (int k = 1; k <= steps; k++)
+	{
+		const Cell *from = &cells_[(k - 1) * bins];
+		Cell *to = &cells_[k * bins];
+		bool reached = false;
+		for (int j = 0; j < bins; j++)
+		{
+			const Cell &parent = from[j];
+			if (parent.cost == kInfinity)
+			{
+				continue;
+			}
+			// speeds allowed by the acceleration and jerk limits, as s bins
+			double a_lo = max(p.a_min, parent.a - p.j_max * dt);
+			double a_hi = min(p.a_max, parent.a + p.j_max * dt);
+			double v_lo = max(0.0, parent.v + a_lo * dt);
+			double v_hi = min(v_limit, parent.v + a_hi * dt);
+			int i_lo = j + (int)ceil(v_lo * dt / p.s_res);
+			int i_hi = min(j + (int)floor(v_hi * dt / p.s_res), s_limit_[k]);
+			for (int i = i_lo; i <= i_hi; i++)
+			{
+				double v = (i - j) * p.s_res / dt;
+				double a = (v - parent.v) / dt;
+				double jerk = (a - parent.a) / dt;
+				double cost = p.w_speed * (v_limit - v) * (v_limit - v) + p.w_accel * a * a + p.w_jerk * jerk * jerk;
+				if (leader_rear_[k] != kInfinity)
+				{
+					double headway = p.s_0 + v * p.t_gap - (leader_rear_[k] - i * p.s_res);
+					cost += (headway > 0.0) ? p.w_headway * headway * headway : 0.0;
+				}
+				cost = parent.cost + cost * dt;
+				if (cost < to[i].cost)
+				{
+					Cell cell = {cost, v, a, j};
+					to[i] = cell;
+					reached = true;
+				}
+			}
+		}
+		if (!reached)
+		{
+			break;
+		}
+		last = k;
+	}
+	if (last < steps)
+	{
+		return false;
+	}
+
+	// cheapest end, then back to the start
+	const Cell *end = &cells_[steps * bins];
+	int best = min_element(end, end + bins, [](const Cell &a, const Cell &b) { return a.cost < b.cost; }) - end;
+	profile.v.resize(steps);
+	for (int k = steps; k >= 1; k--)
+	{
+		const Cell &cell = cells_[k * bins + best];
+		profile.v[k - 1] = cell.v;
+		best = cell.parent;
+	}
+	profile.feasible = true;
+	return true;
+}
@@ -0,0 +1,76 @@
+#ifndef SPEED_PLANNER_H
+#define SPEED_PLANNER_H
+
+#include <vector>
+
+#include "prediction.h"
+
+struct SpeedPlannerParams
+{
+	// horizon: steps of dt seconds, s in bins of s_res metres
+	double dt = 0.5;
+	int steps = 8;
+	double s_res = 0.25;
+	double a_max = 3.0;
+	double a_min = -6.0;
+	double j_max = 8.0;
+	// bumper to bumper gap that must not be undercut, and the headway that
+	// costs when undercut
+	double car_length = 5.0;
+	double s_min = 5.0;
+	double s_0 = 10.0;
+	double t_gap = 1.5;
+	// cost weights per second
+	double w_speed = 1.0;
+	double w_accel = 1.0;
+	double w_jerk = 0.1;
+	double w_headway = 5.0;
+};
+
+// Planned speed over the horizon, knots every dt starting at the reference
+// point; v[k] is the mean speed over step k
+struct SpeedProfile
+{
+	bool feasible = false;
+	double dt = 0.0;
+	std::vector<double> v;
+
+	// speed t after the start, linear between the middles of the steps
+	double speedAt(double t) const;
+};
+
+// Dynamic programming over an s-t graph: every cell (t, s) keeps the cheapest
+// way to get there, together with the speed and acceleration of that way, so
+// an edge's acceleration and jerk follow from its parent alone. Cars ahead in
+// the lane block the cells closer than s_min behind them. The table is flat,
+// step-major, and reused from frame to frame.
+class SpeedPlanner
+{
+public:
+	explicit SpeedPlanner(const SpeedPlannerParams &params = SpeedPlannerParams());
+
+	// ego at s with speed v0 and acceleration a0 in lane t0 seconds from now,
+	// v_limit the highest speed allowed; false if every way hits the leader
+	bool plan(double s, double v0, double a0, double v_limit, int lane, double t0, const TrafficPrediction &prediction,
+			  SpeedProfile &profile);
+
+	const SpeedPlannerParams &params() const { return params_; }
+
+private:
+	struct Cell
+	{
+		double cost;
+		double v;
+		double a;
+		int parent;
+	};
+
+	SpeedPlannerParams params_;
+	std::vector<Cell> cells_;
+	// per step: highest reachable s bin, and the rear of the leader there
+	std::vector<int> s_limit_;
+	std::vector<double> leader_rear_;
+	std::vector<double> leader_speed_;
+};
+
+#endif /* SPEED_PLANNER_H */
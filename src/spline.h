@@ -29,6 +29,7 @@
 
 #include <cstdio>
 #include <cassert>
+#include <cmath>
 #include <vector>
 #include <algorithm>
 
@@ -72,10 +73,17 @@ public:
     std::vector<double> l_solve(const std::vector<double>& b) const;
     std::vector<double> lu_solve(const std::vector<double>& b,
                                  bool is_lu_decomposed=false);
+    // in-place variants for an already decomposed matrix: b is overwritten
+    // by the solution, nothing is allocated
+    void l_solve_inplace(std::vector<double>& b) const;
+    void r_solve_inplace(std::vector<double>& b) const;
+    void lu_solve_inplace(std::vector<double>& b) const;
 
 };
 
 
+class spline_factorization;
+
 // spline interpolation
 class spline
 {
@@ -110,7 +118,141 @@ public:
                       bool force_linear_extrapolation=false);
     void set_points(const std::vector<double>& x,
                     const std::vector<double>& y, bool cubic_spline=true);
+    // cubic spline through x, y reusing the decomposed matrix in cache
+    // when the knot spacing allows it, see spline_factorization
+    void set_points(const std::vector<double>& x,
+                    const std::vector<double>& y, spline_factorization& cache)
+    {
+        assert(x.size()==y.size());
+        set_points(x.data(), y.data(), x.size(), cache);
+    }
+    void set_points(const double* x, const double* y, int n,
+                    spline_factorization& cache);
     double operator() (double x) const;
+    // order-th derivative at x, order 1 or 2
+    double deriv(int order, double x) const;
+    // values and first two derivatives at x[0], ..., x[n-1], any of the
+    // outputs may be NULL; ascending x take one pass over the pieces
+    void eval(const double* x, int n, double* y, double* dy, double* ddy) const;
+
+private:
+    // piece (-1: left extrapolation) and offset from its knot
+    int segment(double x, double& h) const;
+    // the same, searching forward from piece hint, which gets the piece
+    // found: for ascending x every piece is passed once
+    int segment(double x, double& h, int& hint) const;
+    // matrix (if A is given) and right hand side of the system for b[]
+    void assemble(band_matrix* A, std::vector<double>& rhs) const;
+    // r = rhs - A b[] for the matrix of the current knots, without building
+    // it; in the inner rows that is the jump of f' at the knot
+    void residual(const std::vector<double>& rhs, std::vector<double>& r) const;
+    // a[] and c[] once b[] is known
+    void set_coefficients();
+    // coefficients outside [x[0], x[n-1]]
+    void set_extrapolation();
+};
+
+
+// LU-decomposed spline system for the knots it was last built for. While the
+// knot spacing of later fits stays within a relative tolerance of those
+// knots, set_points() skips assembling and decomposing the matrix and solves
+// for the new right hand side with the old factors. That spline passes
+// through every point and keeps f'' continuous, but f' jumps at the knots by
+// the residual of the actual system, so up to max_steps steps of iterative
+// refinement follow; if the jump is still above max_jump then, the matrix is
+// rebuilt after all.
+class spline_factorization
+{
+public:
+    explicit spline_factorization(double tolerance=0.0, double max_jump=1e-6,
+                                  int max_steps=3):
+        m_tolerance(tolerance), m_max_jump(max_jump), m_max_steps(max_steps),
+        m_hits(0), m_misses(0)
+    {
+        ;
+    }
+    // largest jump of f' at a knot a reused decomposition may leave
+    double maxJump() const
+    {
+        return m_max_jump;
+    }
+    // fits that reused the decomposition, and fits that rebuilt it
+    size_t hits() const
+    {
+        return m_hits;
+    }
+    size_t misses() const
+    {
+        return m_misses;
+    }
+
+private:
+    friend class spline;
+    bool matches(const std::vector<double>& x, spline::bd_type left,
+                 spline::bd_type right) const;
+
+    double m_tolerance;
+    double m_max_jump;
+    int m_max_steps;
+    std::vector<double> m_h;                // knot spacing of the matrix
+    spline::bd_type m_left, m_right;
+    band_matrix m_A;
+    // right hand side and residual of the refinement
+    std::vector<double> m_rhs, m_r;
+    size_t m_hits, m_misses;
+};
+
+
+
+// planar curve (x(u), y(u)) through points, u being the accumulated chord
+// length, with a table of arc length over u so points can be placed at exact
+// distances along the curve without root finding
+class parametric_spline
+{
+private:
+    spline m_sx, m_sy;
+    std::vector<double> m_knot_u;           // u of every point
+    // arc length table: s at u = i*m_step, monotonic
+    std::vector<double> m_table_s;
+    double m_step;
+    // parameters and derivatives in sample(), kept to not allocate per
+    // call, so one curve is sampled by one thread at a time
+    mutable std::vector<double> m_work;
+
+public:
+    parametric_spline(): m_step(0.5)
+    {
+        ;
+    }
+    // table_step is the u spacing of the arc length table, which covers u up
+    // to table_length (<= 0: the whole curve); with a cache both coordinate
+    // fits share one decomposition
+    void set_points(const std::vector<double>& x,
+                    const std::vector<double>& y, double table_step=0.5,
+                    spline_factorization* cache=NULL, double table_length=0.0)
+    {
+        assert(x.size()==y.size());
+        set_points(x.data(), y.data(), x.size(), table_step, cache, table_length);
+    }
+    void set_points(const double* x, const double* y, int n,
+                    double table_step=0.5, spline_factorization* cache=NULL,
+                    double table_length=0.0);
+    // arc length of the curve up to point i
+    double knot_length(int i) const;
+    // arc length the table covers
+    double length() const
+    {
+        return m_table_s.back();
+    }
+    // points at the increasing arc lengths s[0], ..., s[n-1], and if given
+    // the heading and signed curvature there from the derivatives
+    void sample(const double* s, int n, double* x, double* y,
+                double* heading=NULL, double* curvature=NULL) const;
+
+private:
+    // parameter at arc length s; hint is the table index to search from and
+    // is moved along, so increasing s cost one pass over the table in total
+    double parameter(double s, size_t& hint) const;
 };
 
 
@@ -118,16 +260,18 @@ public:
 // ---------------------------------------------------------------------
 // implementation part, which could be separated into a cpp file
 // ---------------------------------------------------------------------
+// every member is inline: the header is included into several translation
+// units, each of which uses only some of them
 
 
 // band_matrix implementation
 // -------------------------
 
-band_matrix::band_matrix(int dim, int n_u, int n_l)
+inline band_matrix::band_matrix(int dim, int n_u, int n_l)
 {
     resize(dim, n_u, n_l);
 }
-void band_matrix::resize(int dim, int n_u, int n_l)
+inline void band_matrix::resize(int dim, int n_u, int n_l)
 {
     assert(dim>0);
     assert(n_u>=0);
@@ -141,7 +285,7 @@ void band_matrix::resize(int dim, int n_u, int n_l)
         m_lower[i].resize(dim);
     }
 }
-int band_matrix::dim() const
+inline int band_matrix::dim() const
 {
     if(m_upper.size()>0) {
         return m_upper[0].size();
@@ -153,7 +297,7 @@ int band_matrix::dim() const
 
 // defines the new operator (), so that we can access the elements
 // by A(i,j), index going from i=0,...,dim()-1
-double & band_matrix::operator () (int i, int j)
+inline double & band_matrix::operator () (int i, int j)
 {
     int k=j-i;       // what band is the entry
     assert( (i>=0) && (i<dim()) && (j>=0) && (j<dim()) );
@@ -162,7 +306,7 @@ double & band_matrix::operator () (int i, int j)
     if(k>=0)   return m_upper[k][i];
     else	    return m_lower[-k][i];
 }
-double band_matrix::operator () (int i, int j) const
+inline double band_matrix::operator () (int i, int j) const
 {
     int k=j-i;       // what band is the entry
     assert( (i>=0) && (i<dim()) && (j>=0) && (j<dim()) );
@@ -172,19 +316,19 @@ double band_matrix::operator () (int i, int j) const
     else	    return m_lower[-k][i];
 }
 // second diag (used in LU decomposition), saved in m_lower
-double band_matrix::saved_diag(int i) const
+inline double band_matrix::saved_diag(int i) const
 {
     assert( (i>=0) && (i<dim()) );
     return m_lower[0][i];
 }
-double & band_matrix::saved_diag(int i)
+inline double & band_matrix::saved_diag(int i)
 {
     assert( (i>=0) && (i<dim()) );
     return m_lower[0][i];
 }
 
 // LR-Decomposition of a band matrix
-void band_matrix::lu_decompose()
+inline void band_matrix::lu_decompose()
 {
     int  i_max,j_max;
     int  j_min;
@@ -219,7 +363,7 @@ void band_matrix::lu_decompose()
     }
 }
 // solves Ly=b
-std::vector<double> band_matrix::l_solve(const std::vector<double>& b) const
+inline std::vector<double> band_matrix::l_solve(const std::vector<double>& b) const
 {
     assert( this->dim()==(int)b.size() );
     std::vector<double> x(this->dim());
@@ -234,7 +378,7 @@ std::vector<double> band_matrix::l_solve(const std::vector<double>& b) const
     return x;
 }
 // solves Rx=y
-std::vector<double> band_matrix::r_solve(const std::vector<double>& b) const
+inline std::vector<double> band_matrix::r_solve(const std::vector<double>& b) const
 {
     assert( this->dim()==(int)b.size() );
     std::vector<double> x(this->dim());
@@ -249,7 +393,7 @@ std::vector<double> band_matrix::r_solve(const std::vector<double>& b) const
     return x;
 }
 
-std::vector<double> band_matrix::lu_solve(const std::vector<double>& b,
+inline std::vector<double> band_matrix::lu_solve(const std::vector<double>& b,
         bool is_lu_decomposed)
 {
     assert( this->dim()==(int)b.size() );
@@ -261,6 +405,37 @@ std::vector<double> band_matrix::lu_solve(const std::vector<double>& b,
     x=this->r_solve(y);
     return x;
 }
+// solves Ly=b in place, y[j] for j<i is final when row i is reached
+inline void band_matrix::l_solve_inplace(std::vector<double>& b) const
+{
+    assert( this->dim()==(int)b.size() );
+    int j_start;
+    double sum;
+    for(int i=0; i<this->dim(); i++) {
+        sum=0;
+        j_start=std::max(0,i-this->num_lower());
+        for(int j=j_start; j<i; j++) sum += this->operator()(i,j)*b[j];
+        b[i]=(b[i]*this->saved_diag(i)) - sum;
+    }
+}
+// solves Rx=y in place, bottom up
+inline void band_matrix::r_solve_inplace(std::vector<double>& b) const
+{
+    assert( this->dim()==(int)b.size() );
+    int j_stop;
+    double sum;
+    for(int i=this->dim()-1; i>=0; i--) {
+        sum=0;
+        j_stop=std::min(this->dim()-1,i+this->num_upper());
+        for(int j=i+1; j<=j_stop; j++) sum += this->operator()(i,j)*b[j];
+        b[i]=( b[i] - sum ) / this->operator()(i,i);
+    }
+}
+inline void band_matrix::lu_solve_inplace(std::vector<double>& b) const
+{
+    this->l_solve_inplace(b);
+    this->r_solve_inplace(b);
+}
 
 
 
@@ -268,9 +443,9 @@ std::vector<double> band_matrix::lu_solve(const std::vector<double>& b,
 // spline implementation
 // -----------------------
 
-void spline::set_boundary(spline::bd_type left, double left_value,
-                          spline::bd_type right, double right_value,
-                          bool force_linear_extrapolation)
+inline void spline::set_boundary(spline::bd_type left, double left_value,
+                                 spline::bd_type right, double right_value,
+                                 bool force_linear_extrapolation)
 {
     assert(m_x.size()==0);          // set_points() must not have happened yet
     m_left=left;
@@ -281,8 +456,8 @@ void spline::set_boundary(spline::bd_type left, double left_value,
 }
 
 
-void spline::set_points(const std::vector<double>& x,
-                        const std::vector<double>& y, bool cubic_spline)
+inline void spline::set_points(const std::vector<double>& x,
+                               const std::vector<double>& y, bool cubic_spline)
 {
     assert(x.size()==y.size());
     assert(x.size()>2);
@@ -299,54 +474,13 @@ void spline::set_points(const std::vector<double>& x,
         // for the parameters b[]
         band_matrix A(n,1,1);
         std::vector<double>  rhs(n);
-        for(int i=1; i<n-1; i++) {
-            A(i,i-1)=1.0/3.0*(x[i]-x[i-1]);
-            A(i,i)=2.0/3.0*(x[i+1]-x[i-1]);
-            A(i,i+1)=1.0/3.0*(x[i+1]-x[i]);
-            rhs[i]=(y[i+1]-y[i])/(x[i+1]-x[i]) - (y[i]-y[i-1])/(x[i]-x[i-1]);
-        }
-        // boundary conditions
-        if(m_left == spline::second_deriv) {
-            // 2*b[0] = f''
-            A(0,0)=2.0;
-            A(0,1)=0.0;
-            rhs[0]=m_left_value;
-        } else if(m_left == spline::first_deriv) {
-            // c[0] = f', needs to be re-expressed in terms of b:
-            // (2b[0]+b[1])(x[1]-x[0]) = 3 ((y[1]-y[0])/(x[1]-x[0]) - f')
-            A(0,0)=2.0*(x[1]-x[0]);
-            A(0,1)=1.0*(x[1]-x[0]);
-            rhs[0]=3.0*((y[1]-y[0])/(x[1]-x[0])-m_left_value);
-        } else {
-            assert(false);
-        }
-        if(m_right == spline::second_deriv) {
-            // 2*b[n-1] = f''
-            A(n-1,n-1)=2.0;
-            A(n-1,n-2)=0.0;
-            rhs[n-1]=m_right_value;
-        } else if(m_right == spline::first_deriv) {
-            // c[n-1] = f', needs to be re-expressed in terms of b:
-            // (b[n-2]+2b[n-1])(x[n-1]-x[n-2])
-            // = 3 (f' - (y[n-1]-y[n-2])/(x[n-1]-x[n-2]))
-            A(n-1,n-1)=2.0*(x[n-1]-x[n-2]);
-            A(n-1,n-2)=1.0*(x[n-1]-x[n-2]);
-            rhs[n-1]=3.0*(m_right_value-(y[n-1]-y[n-2])/(x[n-1]-x[n-2]));
-        } else {
-            assert(false);
-        }
+        assemble(&A, rhs);
 
         // solve the equation system to obtain the parameters b[]
         m_b=A.lu_solve(rhs);
 
         // calculate parameters a[] and c[] based on b[]
-        m_a.resize(n);
-        m_c.resize(n);
-        for(int i=0; i<n-1; i++) {
-            m_a[i]=1.0/3.0*(m_b[i+1]-m_b[i])/(x[i+1]-x[i]);
-            m_c[i]=(y[i+1]-y[i])/(x[i+1]-x[i])
-                   - 1.0/3.0*(2.0*m_b[i]+m_b[i+1])*(x[i+1]-x[i]);
-        }
+        set_coefficients();
     } else { // linear interpolation
         m_a.resize(n);
         m_b.resize(n);
@@ -358,13 +492,166 @@ void spline::set_points(const std::vector<double>& x,
         }
     }
 
+    set_extrapolation();
+}
+
+inline void spline::set_points(const double* x, const double* y, int n,
+                               spline_factorization& cache)
+{
+    assert(n>2);
+    m_x.assign(x, x+n);
+    m_y.assign(y, y+n);
+    for(int i=0; i<n-1; i++) {
+        assert(m_x[i]<m_x[i+1]);
+    }
+
+    // the right hand side goes straight into b[], it is solved in place
+    m_b.resize(n);
+    bool reused=false;
+    if(cache.matches(m_x, m_left, m_right)) {
+        cache.m_rhs.resize(n);
+        assemble(NULL, cache.m_rhs);
+        m_b=cache.m_rhs;
+        cache.m_A.lu_solve_inplace(m_b);
+        // iterative refinement: the old factors solve for the correction
+        for(int step=0; ; step++) {
+            residual(cache.m_rhs, cache.m_r);
+            double jump=0.0;
+            for(int i=0; i<n; i++) {
+                jump=std::max(jump, std::fabs(cache.m_r[i]));
+            }
+            if(jump<=cache.m_max_jump) {
+                reused=true;
+                break;
+            }
+            if(step==cache.m_max_steps) {
+                break;
+            }
+            cache.m_A.lu_solve_inplace(cache.m_r);
+            for(int i=0; i<n; i++) {
+                m_b[i]+=cache.m_r[i];
+            }
+        }
+    }
+    if(reused) {
+        cache.m_hits++;
+    } else {
+        cache.m_A.resize(n,1,1);
+        assemble(&cache.m_A, m_b);
+        cache.m_A.lu_decompose();
+        cache.m_A.lu_solve_inplace(m_b);
+        cache.m_h.resize(n-1);
+        for(int i=0; i<n-1; i++) {
+            cache.m_h[i]=x[i+1]-x[i];
+        }
+        cache.m_left=m_left;
+        cache.m_right=m_right;
+        cache.m_misses++;
+    }
+    set_coefficients();
+    set_extrapolation();
+}
+
+inline void spline::assemble(band_matrix* A, std::vector<double>& rhs) const
+{
+    const std::vector<double>& x=m_x;
+    const std::vector<double>& y=m_y;
+    int   n=x.size();
+    for(int i=1; i<n-1; i++) {
+        if(A) {
+            (*A)(i,i-1)=1.0/3.0*(x[i]-x[i-1]);
+            (*A)(i,i)=2.0/3.0*(x[i+1]-x[i-1]);
+            (*A)(i,i+1)=1.0/3.0*(x[i+1]-x[i]);
+        }
+        rhs[i]=(y[i+1]-y[i])/(x[i+1]-x[i]) - (y[i]-y[i-1])/(x[i]-x[i-1]);
+    }
+    // boundary conditions
+    if(m_left == spline::second_deriv) {
+        // 2*b[0] = f''
+        if(A) {
+            (*A)(0,0)=2.0;
+            (*A)(0,1)=0.0;
+        }
+        rhs[0]=m_left_value;
+    } else if(m_left == spline::first_deriv) {
+        // c[0] = f', needs to be re-expressed in terms of b:
+        // (2b[0]+b[1])(x[1]-x[0]) = 3 ((y[1]-y[0])/(x[1]-x[0]) - f')
+        if(A) {
+            (*A)(0,0)=2.0*(x[1]-x[0]);
+            (*A)(0,1)=1.0*(x[1]-x[0]);
+        }
+        rhs[0]=3.0*((y[1]-y[0])/(x[1]-x[0])-m_left_value);
+    } else {
+        assert(false);
+    }
+    if(m_right == spline::second_deriv) {
+        // 2*b[n-1] = f''
+        if(A) {
+            (*A)(n-1,n-1)=2.0;
+            (*A)(n-1,n-2)=0.0;
+        }
+        rhs[n-1]=m_right_value;
+    } else if(m_right == spline::first_deriv) {
+        // c[n-1] = f', needs to be re-expressed in terms of b:
+        // (b[n-2]+2b[n-1])(x[n-1]-x[n-2])
+        // = 3 (f' - (y[n-1]-y[n-2])/(x[n-1]-x[n-2]))
+        if(A) {
+            (*A)(n-1,n-1)=2.0*(x[n-1]-x[n-2]);
+            (*A)(n-1,n-2)=1.0*(x[n-1]-x[n-2]);
+        }
+        rhs[n-1]=3.0*(m_right_value-(y[n-1]-y[n-2])/(x[n-1]-x[n-2]));
+    } else {
+        assert(false);
+    }
+}
+
+inline void spline::residual(const std::vector<double>& rhs, std::vector<double>& r) const
+{
+    const std::vector<double>& x=m_x;
+    const std::vector<double>& b=m_b;
+    int   n=x.size();
+    r.resize(n);
+    for(int i=1; i<n-1; i++) {
+        r[i]=rhs[i] - 1.0/3.0*(x[i]-x[i-1])*b[i-1]
+             - 2.0/3.0*(x[i+1]-x[i-1])*b[i] - 1.0/3.0*(x[i+1]-x[i])*b[i+1];
+    }
+    // the boundary rows as in assemble()
+    if(m_left == spline::second_deriv) {
+        r[0]=rhs[0] - 2.0*b[0];
+    } else {
+        r[0]=rhs[0] - (2.0*b[0]+b[1])*(x[1]-x[0]);
+    }
+    if(m_right == spline::second_deriv) {
+        r[n-1]=rhs[n-1] - 2.0*b[n-1];
+    } else {
+        r[n-1]=rhs[n-1] - (b[n-2]+2.0*b[n-1])*(x[n-1]-x[n-2]);
+    }
+}
+
+inline void spline::set_coefficients()
+{
+    const std::vector<double>& x=m_x;
+    const std::vector<double>& y=m_y;
+    int   n=x.size();
+    m_a.resize(n);
+    m_c.resize(n);
+    for(int i=0; i<n-1; i++) {
+        m_a[i]=1.0/3.0*(m_b[i+1]-m_b[i])/(x[i+1]-x[i]);
+        m_c[i]=(y[i+1]-y[i])/(x[i+1]-x[i])
+               - 1.0/3.0*(2.0*m_b[i]+m_b[i+1])*(x[i+1]-x[i]);
+    }
+}
+
+inline void spline::set_extrapolation()
+{
+    int   n=m_x.size();
     // for left extrapolation coefficients
     m_b0 = (m_force_linear_extrapolation==false) ? m_b[0] : 0.0;
     m_c0 = m_c[0];
 
     // for the right extrapolation coefficients
     // f_{n-1}(x) = b*(x-x_{n-1})^2 + c*(x-x_{n-1}) + y_{n-1}
-    double h=x[n-1]-x[n-2];
+    double h=m_x[n-1]-m_x[n-2];
     // m_b[n-1] is determined by the boundary condition
     m_a[n-1]=0.0;
     m_c[n-1]=3.0*m_a[n-2]*h*h+2.0*m_b[n-2]*h+m_c[n-2];   // = f'_{n-2}(x_{n-1})
@@ -372,7 +659,151 @@ void spline::set_points(const std::vector<double>& x,
         m_b[n-1]=0.0;
 }
 
-double spline::operator() (double x) const
+inline bool spline_factorization::matches(const std::vector<double>& x,
+                                          spline::bd_type left, spline::bd_type right) const
+{
+    if(m_h.size()+1!=x.size() || left!=m_left || right!=m_right) {
+        return false;
+    }
+    for(size_t i=0; i<m_h.size(); i++) {
+        double h=x[i+1]-x[i];
+        if(std::fabs(h-m_h[i]) > m_tolerance*m_h[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// parametric_spline implementation
+// -----------------------------------
+
+inline void parametric_spline::set_points(const double* x, const double* y, int n,
+                                          double table_step, spline_factorization* cache,
+                                          double table_length)
+{
+    assert(table_step>0.0);
+    m_knot_u.resize(n);
+    m_knot_u[0]=0.0;
+    for(int i=1; i<n; i++) {
+        double dx=x[i]-x[i-1];
+        double dy=y[i]-y[i-1];
+        m_knot_u[i]=m_knot_u[i-1]+std::sqrt(dx*dx+dy*dy);
+    }
+    if(cache) {
+        m_sx.set_points(m_knot_u.data(), x, n, *cache);
+        m_sy.set_points(m_knot_u.data(), y, n, *cache);
+    } else {
+        m_sx.set_points(m_knot_u, std::vector<double>(x, x+n));
+        m_sy.set_points(m_knot_u, std::vector<double>(y, y+n));
+    }
+
+    // chords between table samples, the curve bends little within a step
+    m_step=table_step;
+    double u_max=(table_length>0.0) ? std::min(table_length, m_knot_u[n-1]) : m_knot_u[n-1];
+    int samples=std::max((int)std::ceil(u_max/m_step), 1)+1;
+    m_table_s.resize(samples);
+    m_table_s[0]=0.0;
+    double x_last=m_sx(0.0);
+    double y_last=m_sy(0.0);
+    for(int i=1; i<samples; i++) {
+        double u=i*m_step;
+        double x_u=m_sx(u);
+        double y_u=m_sy(u);
+        m_table_s[i]=m_table_s[i-1]+std::sqrt((x_u-x_last)*(x_u-x_last)+(y_u-y_last)*(y_u-y_last));
+        x_last=x_u;
+        y_last=y_u;
+    }
+}
+
+inline double parametric_spline::knot_length(int i) const
+{
+    double k=m_knot_u[i]/m_step;
+    size_t k0=std::min((size_t)k, m_table_s.size()-2);
+    return m_table_s[k0]+(k-k0)*(m_table_s[k0+1]-m_table_s[k0]);
+}
+
+inline double parametric_spline::parameter(double s, size_t& hint) const
+{
+    size_t last=m_table_s.size()-1;
+    hint=std::min(hint, last-1);
+    while(hint+1<last && m_table_s[hint+1]<s) {
+        hint++;
+    }
+    // linear within the table, beyond its ends u runs on at the last rate
+    double ds=m_table_s[hint+1]-m_table_s[hint];
+    return (hint+(s-m_table_s[hint])/(ds>0.0 ? ds : 1.0))*m_step;
+}
+
+inline void parametric_spline::sample(const double* s, int n, double* x, double* y,
+                                      double* heading, double* curvature) const
+{
+    if(n<=0) {
+        return;
+    }
+    m_work.resize(5*n);
+    double* u=&m_work[0];
+    size_t hint=0;
+    for(int i=0; i<n; i++) {
+        u[i]=parameter(s[i], hint);
+    }
+    if(heading==NULL && curvature==NULL) {
+        m_sx.eval(u, n, x, NULL, NULL);
+        m_sy.eval(u, n, y, NULL, NULL);
+        return;
+    }
+    double* dx=&m_work[n];
+    double* dy=&m_work[2*n];
+    double* ddx=&m_work[3*n];
+    double* ddy=&m_work[4*n];
+    m_sx.eval(u, n, x, dx, ddx);
+    m_sy.eval(u, n, y, dy, ddy);
+    for(int i=0; i<n; i++) {
+        if(heading) {
+            heading[i]=std::atan2(dy[i], dx[i]);
+        }
+        if(curvature) {
+            double speed2=dx[i]*dx[i]+dy[i]*dy[i];
+            curvature[i]=(dx[i]*ddy[i]-dy[i]*ddx[i])/(speed2*std::sqrt(speed2));
+        }
+    }
+}
+
+inline int spline::segment(double x, double& h) const
+{
+    size_t n=m_x.size();
+    // find the closest point m_x[idx] < x, idx=0 even if x<m_x[0]
+    std::vector<double>::const_iterator it;
+    it=std::lower_bound(m_x.begin(),m_x.end(),x);
+    int idx=std::max( int(it-m_x.begin())-1, 0);
+    h=x-m_x[idx];
+    if(x<m_x[0]) {
+        return -1;
+    } else if(x>m_x[n-1]) {
+        idx=n-1;
+        h=x-m_x[idx];
+    }
+    return idx;
+}
+
+inline int spline::segment(double x, double& h, int& hint) const
+{
+    int n=m_x.size();
+    // x below the last one, start over
+    if(hint<0 || hint>=n || x<=m_x[hint]) {
+        hint=0;
+    }
+    while(hint+1<n && m_x[hint+1]<x) {
+        hint++;
+    }
+    if(x<m_x[0]) {
+        h=x-m_x[0];
+        return -1;
+    }
+    h=x-m_x[hint];
+    return hint;
+}
+
+inline double spline::operator() (double x) const
 {
     size_t n=m_x.size();
     // find the closest point m_x[idx] < x, idx=0 even if x<m_x[0]
@@ -395,6 +826,43 @@ double spline::operator() (double x) const
     return interpol;
 }
 
+inline double spline::deriv(int order, double x) const
+{
+    assert(order==1 || order==2);
+    double h;
+    int idx=segment(x, h);
+    // the extrapolation pieces are quadratics
+    double a=(idx<0) ? 0.0 : m_a[idx];
+    double b=(idx<0) ? m_b0 : m_b[idx];
+    double c=(idx<0) ? m_c0 : m_c[idx];
+    if(order==1) {
+        return (3.0*a*h + 2.0*b)*h + c;
+    }
+    return 6.0*a*h + 2.0*b;
+}
+
+inline void spline::eval(const double* x, int n, double* y, double* dy, double* ddy) const
+{
+    int hint=0;
+    for(int i=0; i<n; i++) {
+        double h;
+        int idx=segment(x[i], h, hint);
+        double a=(idx<0) ? 0.0 : m_a[idx];
+        double b=(idx<0) ? m_b0 : m_b[idx];
+        double c=(idx<0) ? m_c0 : m_c[idx];
+        double y0=(idx<0) ? m_y[0] : m_y[idx];
+        if(y) {
+            y[i]=((a*h + b)*h + c)*h + y0;
+        }
+        if(dy) {
+            dy[i]=(3.0*a*h + 2.0*b)*h + c;
+        }
+        if(ddy) {
+            ddy[i]=6.0*a*h + 2.0*b;
+        }
+    }
+}
+
 
 } // namespace tk
 
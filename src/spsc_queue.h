@@ -0,0 +1,57 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free ring buffer for exactly one producer and one consumer
+// thread. Neither side ever blocks: push fails when full, pop when empty.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+public:
+	SpscQueue() : head_(0), tail_(0) {}
+
+	SpscQueue(const SpscQueue &) = delete;
+	SpscQueue &operator=(const SpscQueue &) = delete;
+
+	// producer side
+	bool push(const T &value)
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		size_t next = (tail + 1) % kSlots;
+		if (next == head_.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		slots_[tail] = value;
+		tail_.store(next, std::memory_order_release);
+		return true;
+	}
+
+	// consumer side
+	bool pop(T &value)
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		value = slots_[head];
+		head_.store((head + 1) % kSlots, std::memory_order_release);
+		return true;
+	}
+
+	bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+private:
+	// one slot stays free to tell full from empty
+	static const size_t kSlots = Capacity + 1;
+
+	// on separate cache lines, each is written by one side only
+	alignas(64) std::atomic<size_t> head_;
+	alignas(64) std::atomic<size_t> tail_;
+	T slots_[kSlots];
+};
+
+#endif /* SPSC_QUEUE_H */
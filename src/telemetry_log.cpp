@@ -0,0 +1,129 @@
+#include "telemetry_log.h"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace std;
+using json = nlohmann::json;
+
+// values of a JSON array of numbers, over the elements of values
+static void readNumbers(const json &array, vector<double> &values)
+{
+	values.resize(array.size());
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		values[i] = array[i];
+	}
+}
+
+void parseTelemetry(const json &data, Telemetry &telemetry)
+{
+	// Main car's localization Data
+	telemetry.car_x = data["x"];
+	telemetry.car_y = data["y"];
+	telemetry.car_s = data["s"];
+	telemetry.car_d = data["d"];
+	telemetry.car_yaw = data["yaw"];
+	telemetry.car_speed = data["speed"];
+
+	// Previous path data given to the Planner
+	readNumbers(data["previous_path_x"], telemetry.previous_path_x);
+	readNumbers(data["previous_path_y"], telemetry.previous_path_y);
+
+	// Previous path's end s and d values
+	telemetry.end_path_s = data["end_path_s"];
+	telemetry.end_path_d = data["end_path_d"];
+
+	// Sensor Fusion Data, a list of all other cars on the same side of the road.
+	const json &sensor_fusion = data["sensor_fusion"];
+	telemetry.sensor_fusion.resize(sensor_fusion.size());
+	for (size_t i = 0; i < telemetry.sensor_fusion.size(); i++)
+	{
+		readNumbers(sensor_fusion[i], telemetry.sensor_fusion[i]);
+	}
+}
+
+json telemetryJson(const Telemetry &telemetry)
+{
+	json data;
+	data["x"] = telemetry.car_x;
+	data["y"] = telemetry.car_y;
+	data["s"] = telemetry.car_s;
+	data["d"] = telemetry.car_d;
+	data["yaw"] = telemetry.car_yaw;
+	data["speed"] = telemetry.car_speed;
+	data["previous_path_x"] = telemetry.previous_path_x;
+	data["previous_path_y"] = telemetry.previous_path_y;
+	data["end_path_s"] = telemetry.end_path_s;
+	data["end_path_d"] = telemetry.end_path_d;
+	data["sensor_fusion"] = telemetry.sensor_fusion;
+	return data;
+}
+
+// appends the JSON array of values to msg
+static void appendNumbers(const vector<double> &values, string &msg)
+{
+	char number[32];
+	msg += '[';
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		// enough digits to read back the same double
+		int length = snprintf(number, sizeof(number), (i == 0) ? "%.17g" : ",%.17g", values[i]);
+		msg.append(number, length);
+	}
+	msg += ']';
+}
+
+void controlMessage(const vector<double> &x, const vector<double> &y, string &msg)
+{
+	msg.assign("42[\"control\",{\"next_x\":");
+	appendNumbers(x, msg);
+	msg += ",\"next_y\":";
+	appendNumbers(y, msg);
+	msg += "}]";
+}
+
+bool TelemetryRecorder::open(const string &path)
+{
+	out_.open(path, ios::out | ios::trunc);
+	return out_.is_open();
+}
+
+void TelemetryRecorder::record(const json &data)
+{
+	out_ << data.dump() << '\n';
+	out_.flush();
+}
+
+bool loadTelemetryLog(const string &path, vector<Telemetry> &frames)
+{
+	ifstream in(path);
+	if (!in)
+	{
+		return false;
+	}
+	frames.clear();
+	string line;
+	int number = 0;
+	while (getline(in, line))
+	{
+		number++;
+		if (line.empty())
+		{
+			continue;
+		}
+		try
+		{
+			Telemetry telemetry;
+			parseTelemetry(json::parse(line), telemetry);
+			frames.push_back(telemetry);
+		}
+		catch (const exception &e)
+		{
+			// a session cut off mid-line ends there
+			cerr << path << ":" << number << ": " << e.what() << endl;
+			break;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,40 @@
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "planner.h"
+
+// Telemetry from the data object of a simulator telemetry message, into the
+// vectors telemetry already has, so a reused Telemetry allocates nothing once
+// their capacity has grown
+void parseTelemetry(const nlohmann::json &data, Telemetry &telemetry);
+// the data object of a telemetry message holding telemetry
+nlohmann::json telemetryJson(const Telemetry &telemetry);
+
+// Control message sending the path x, y to the simulator, written over msg
+// without building a JSON object, so a reused msg allocates nothing once
+// grown
+void controlMessage(const std::vector<double> &x, const std::vector<double> &y, std::string &msg);
+
+// Writes the data object of every telemetry message to a file, one per line,
+// so the session can be replayed offline (replay_bench)
+class TelemetryRecorder
+{
+public:
+	bool open(const std::string &path);
+	bool isOpen() const { return out_.is_open(); }
+	// flushed per frame, the server is usually stopped with a signal
+	void record(const nlohmann::json &data);
+
+private:
+	std::ofstream out_;
+};
+
+// every frame of a recorded session, false if the file cannot be read
+bool loadTelemetryLog(const std::string &path, std::vector<Telemetry> &frames);
+
+#endif /* TELEMETRY_LOG_H */
@@ -0,0 +1,146 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+ThreadPool::ThreadPool(int num_threads)
+	: queued_(0)
+{
+	for (int i = 0; i < num_threads; i++)
+	{
+		queues_.emplace_back(new Queue());
+	}
+	for (int i = 0; i < num_threads; i++)
+	{
+		workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(sleep_mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+	for (size_t i = 0; i < workers_.size(); i++)
+	{
+		workers_[i].join();
+	}
+}
+
+bool ThreadPool::pop(int queue, bool back, Task &task)
+{
+	Queue &q = *queues_[queue];
+	lock_guard<mutex> lock(q.mutex);
+	if (q.head == q.tasks.size())
+	{
+		return false;
+	}
+	if (back)
+	{
+		task = q.tasks.back();
+		q.tasks.pop_back();
+	}
+	else
+	{
+		task = q.tasks[q.head++];
+	}
+	if (q.head == q.tasks.size())
+	{
+		q.tasks.clear();
+		q.head = 0;
+	}
+	return true;
+}
+
+bool ThreadPool::runOne(int self)
+{
+	Task task;
+	bool found = (self >= 0) && pop(self, true, task);
+	int n = queues_.size();
+	for (int k = 1; !found && k <= n; k++)
+	{
+		int victim = (self + k + n) % n;
+		found = pop(victim, false, task);
+	}
+	if (!found)
+	{
+		return false;
+	}
+	queued_.fetch_sub(1);
+
+	(*task.f)(task.index);
+
+	// decrement under the lock: the waiter may destroy the batch as soon as
+	// it sees zero
+	Batch *batch = task.batch;
+	lock_guard<mutex> lock(batch->mutex);
+	if (batch->remaining.fetch_sub(1) == 1)
+	{
+		batch->done.notify_all();
+	}
+	return true;
+}
+
+void ThreadPool::workerLoop(int self)
+{
+	while (true)
+	{
+		if (runOne(self))
+		{
+			continue;
+		}
+		unique_lock<mutex> lock(sleep_mutex_);
+		wake_.wait(lock, [this]() { return stop_ || queued_.load() > 0; });
+		if (stop_ && queued_.load() == 0)
+		{
+			return;
+		}
+	}
+}
+
+void ThreadPool::parallelFor(int n, const function<void(int)> &f)
+{
+	if (n <= 0)
+	{
+		return;
+	}
+	if (workers_.empty())
+	{
+		for (int i = 0; i < n; i++)
+		{
+			f(i);
+		}
+		return;
+	}
+
+	Batch batch(n);
+	int num_queues = queues_.size();
+	for (int q = 0; q < num_queues; q++)
+	{
+		Queue &queue = *queues_[q];
+		lock_guard<mutex> lock(queue.mutex);
+		// contiguous chunks, owners work front to back through their own
+		for (int i = min(n, (q + 1) * n / num_queues) - 1; i >= q * n / num_queues; i--)
+		{
+			Task task = {&f, i, &batch};
+			queue.tasks.push_back(task);
+		}
+	}
+	// published once every task can be popped, so woken workers find them;
+	// workers that already took some may have driven the count below zero
+	{
+		lock_guard<mutex> lock(sleep_mutex_);
+		queued_.fetch_add(n);
+	}
+	wake_.notify_all();
+
+	// help until nothing is left to steal, then wait for the stragglers
+	while (batch.remaining.load() > 0 && runOne(-1))
+	{
+	}
+	unique_lock<mutex> lock(batch.mutex);
+	batch.done.wait(lock, [&batch]() { return batch.remaining.load() == 0; });
+}
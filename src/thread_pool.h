@@ -0,0 +1,68 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool: every worker owns a task deque, pops its own tasks
+// from the back and steals from the front of the others when it runs dry.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(int num_threads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	int size() const { return workers_.size(); }
+
+	// Runs f(i) for every i in [0, n) and returns once all calls are done.
+	// The calling thread takes part, so a pool without workers runs inline.
+	void parallelFor(int n, const std::function<void(int)> &f);
+
+private:
+	struct Batch
+	{
+		explicit Batch(int n) : remaining(n) {}
+		std::atomic<int> remaining;
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+
+	struct Task
+	{
+		const std::function<void(int)> *f;
+		int index;
+		Batch *batch;
+	};
+
+	// tasks[head, end) are queued; a vector keeps its storage once the
+	// queue runs empty, so steady-state batches allocate nothing
+	struct Queue
+	{
+		std::mutex mutex;
+		std::vector<Task> tasks;
+		size_t head = 0;
+	};
+
+	void workerLoop(int self);
+	// runs one task from queue self (-1: none of its own), or a stolen one
+	bool runOne(int self);
+	bool pop(int queue, bool back, Task &task);
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> workers_;
+
+	std::mutex sleep_mutex_;
+	std::condition_variable wake_;
+	std::atomic<int> queued_;
+	bool stop_ = false;
+};
+
+#endif /* THREAD_POOL_H */
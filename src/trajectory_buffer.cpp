@@ -0,0 +1,54 @@
+#include "trajectory_buffer.h"
+
+#include <cmath>
+
+using namespace std;
+
+// the points come back through JSON
+static const double kTolerance = 1e-3;
+
+static bool samePoint(const TrajectoryPoint &point, double x, double y)
+{
+	return fabs(point.x - x) < kTolerance && fabs(point.y - y) < kTolerance;
+}
+
+bool TrajectoryBuffer::resync(const vector<double> &previous_path_x, const vector<double> &previous_path_y)
+{
+	int remaining = previous_path_x.size();
+	int consumed = size_ - remaining;
+	if (remaining == 0 || consumed < 0 || !samePoint((*this)[consumed], previous_path_x[0], previous_path_y[0]) ||
+		!samePoint((*this)[size_ - 1], previous_path_x[remaining - 1], previous_path_y[remaining - 1]))
+	{
+		clear();
+		return false;
+	}
+	head_ = (head_ + consumed) & (kCapacity - 1);
+	size_ = remaining;
+	return true;
+}
+
+void TrajectoryBuffer::truncate(int n)
+{
+	if (n < size_)
+	{
+		size_ = n < 0 ? 0 : n;
+	}
+}
+
+void TrajectoryBuffer::shiftS(double offset)
+{
+	for (int i = 0; i < size_; i++)
+	{
+		(*this)[i].s += offset;
+	}
+}
+
+bool TrajectoryBuffer::push(const TrajectoryPoint &point)
+{
+	if (size_ == kCapacity)
+	{
+		return false;
+	}
+	(*this)[size_++] = point;
+	return true;
+}
@@ -0,0 +1,51 @@
+#ifndef TRAJECTORY_BUFFER_H
+#define TRAJECTORY_BUFFER_H
+
+#include <vector>
+
+// State of the car at one emitted path point
+struct TrajectoryPoint
+{
+	double x;
+	double y;
+	double s;
+	double d;
+	// speed the point is reached with, acceleration and jerk there
+	double v;
+	double a;
+	double jerk;
+};
+
+// Ring buffer of the points sent to the simulator that it has not driven yet.
+// The simulator consumes points from the front and echoes the rest back as
+// the previous path, so the planner's own states stay aligned by index.
+class TrajectoryBuffer
+{
+public:
+	static const int kCapacity = 64;
+
+	int size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+	void clear() { size_ = 0; }
+
+	// i-th point not consumed yet
+	const TrajectoryPoint &operator[](int i) const { return points_[(head_ + i) & (kCapacity - 1)]; }
+	TrajectoryPoint &operator[](int i) { return points_[(head_ + i) & (kCapacity - 1)]; }
+
+	// drops the points the simulator consumed since the last path was sent,
+	// or everything if previous path is not what is left of that path
+	bool resync(const std::vector<double> &previous_path_x, const std::vector<double> &previous_path_y);
+	// keeps the first n points
+	void truncate(int n);
+	// adds offset to the s of every point
+	void shiftS(double offset);
+	// false when full
+	bool push(const TrajectoryPoint &point);
+
+private:
+	TrajectoryPoint points_[kCapacity];
+	int head_ = 0;
+	int size_ = 0;
+};
+
+#endif /* TRAJECTORY_BUFFER_H */
@@ -0,0 +1,144 @@
+#include "velocity_profile.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+VelocityProfile::VelocityProfile(double v0, double a0)
+{
+	Phase start = {0.0, 0.0, v0, a0, 0.0};
+	phases_[0] = start;
+}
+
+void VelocityProfile::append(double duration, double jerk)
+{
+	if (duration <= 0.0 || num_phases_ == kMaxPhases)
+	{
+		return;
+	}
+	Phase &phase = phases_[num_phases_];
+	phase.jerk = jerk;
+	double t = duration;
+	Phase next;
+	next.t0 = phase.t0 + t;
+	next.s0 = phase.s0 + phase.v0 * t + phase.a0 * t * t / 2 + jerk * t * t * t / 6;
+	next.v0 = phase.v0 + phase.a0 * t + jerk * t * t / 2;
+	next.a0 = phase.a0 + jerk * t;
+	next.jerk = 0.0;
+	phases_[++num_phases_] = next;
+}
+
+void VelocityProfile::appendSpeedChange(double v_target, double a_max, double j_max)
+{
+	const Phase &start = phases_[num_phases_];
+	double v0 = start.v0;
+	double a0 = start.a0;
+
+	// speed reached when a0 is ramped out straight away decides the direction
+	double v_ramp = v0 + a0 * fabs(a0) / (2 * j_max);
+	double dir = (v_target >= v_ramp) ? 1.0 : -1.0;
+
+	// in the frame where the speed goes up
+	double a = dir * a0;
+	double dv = dir * (v_target - v0);
+	double a_peak = (a > a_max) ? a_max : min(a_max, sqrt(max(0.0, j_max * dv + a * a / 2)));
+	double jerk_1 = (a_peak >= a) ? j_max : -j_max;
+
+	double t_1 = fabs(a_peak - a) / j_max;
+	double t_3 = a_peak / j_max;
+	double dv_1 = (a_peak * a_peak - a * a) / (2 * jerk_1);
+	double dv_3 = a_peak * a_peak / (2 * j_max);
+	double t_2 = (a_peak > 1e-9) ? max(0.0, (dv - dv_1 - dv_3) / a_peak) : 0.0;
+
+	append(t_1, dir * jerk_1);
+	append(t_2, 0.0);
+	append(t_3, -dir * j_max);
+}
+
+void VelocityProfile::finish()
+{
+	// rounding leaves a tiny acceleration at the end
+	Phase &end = phases_[num_phases_];
+	end.a0 = 0.0;
+	end.jerk = 0.0;
+	end.v0 = max(end.v0, 0.0);
+}
+
+VelocityProfile VelocityProfile::toSpeed(double v0, double a0, double v_target, double a_max, double j_max)
+{
+	VelocityProfile profile(v0, a0);
+	profile.appendSpeedChange(v_target, a_max, j_max);
+	profile.finish();
+	return profile;
+}
+
+VelocityProfile VelocityProfile::toStop(double v0, double a0, double s_stop, double a_max, double j_max)
+{
+	// ramp a0 out, cruise, then brake
+	VelocityProfile profile(v0, a0);
+	profile.append(fabs(a0) / j_max, (a0 > 0) ? -j_max : j_max);
+	const Phase &ramped = profile.phases_[profile.num_phases_];
+
+	VelocityProfile brake = toSpeed(ramped.v0, 0.0, 0.0, a_max, j_max);
+	double cruise = s_stop - ramped.s0 - brake.distance();
+	if (ramped.v0 <= 0.0 || cruise < 0.0)
+	{
+		return toSpeed(v0, a0, 0.0, a_max, j_max);
+	}
+
+	profile.append(cruise / ramped.v0, 0.0);
+	profile.appendSpeedChange(0.0, a_max, j_max);
+	profile.finish();
+	return profile;
+}
+
+void VelocityProfile::sample(double t, double &s, double &v, double &a) const
+{
+	int p = 0;
+	while (p < num_phases_ && t >= phases_[p + 1].t0)
+	{
+		p++;
+	}
+	const Phase &phase = phases_[p];
+	double tau = max(0.0, t - phase.t0);
+	s = phase.s0 + phase.v0 * tau + phase.a0 * tau * tau / 2 + phase.jerk * tau * tau * tau / 6;
+	v = phase.v0 + phase.a0 * tau + phase.jerk * tau * tau / 2;
+	a = phase.a0 + phase.jerk * tau;
+}
+
+void VelocityProfile::sample(double t0, double dt, int n, double *s, double *v, double *a) const
+{
+	int i = 0;
+	// samples before the start hold the initial state
+	while (i < n && t0 + i * dt < 0.0)
+	{
+		s[i] = 0.0;
+		v[i] = phases_[0].v0;
+		a[i] = phases_[0].a0;
+		i++;
+	}
+	for (int p = 0; p <= num_phases_; p++)
+	{
+		const Phase &phase = phases_[p];
+		// first sample at or after the end of this phase
+		int end = n;
+		if (p < num_phases_)
+		{
+			end = max(i, min(n, (int)ceil((phases_[p + 1].t0 - t0) / dt)));
+		}
+		double s0 = phase.s0;
+		double v0 = phase.v0;
+		double a0 = phase.a0;
+		double jerk = phase.jerk;
+		double t_start = t0 - phase.t0;
+		for (int k = i; k < end; k++)
+		{
+			double tau = t_start + k * dt;
+			s[k] = s0 + tau * (v0 + tau * (a0 / 2 + tau * jerk / 6));
+			v[k] = v0 + tau * (a0 + tau * jerk / 2);
+			a[k] = a0 + tau * jerk;
+		}
+		i = end;
+	}
+}
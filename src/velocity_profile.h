@@ -0,0 +1,50 @@
+#ifndef VELOCITY_PROFILE_H
+#define VELOCITY_PROFILE_H
+
+// Jerk-limited (S-curve) longitudinal profile in closed form: a few phases of
+// constant jerk, each a cubic in time, followed by constant speed.
+class VelocityProfile
+{
+public:
+	// from speed v0 and acceleration a0 to v_target, |a| <= a_max, |jerk| <= j_max
+	static VelocityProfile toSpeed(double v0, double a0, double v_target, double a_max, double j_max);
+	// from v0, a0 to a standstill s_stop ahead: keeps the speed reached once
+	// a0 is ramped out and brakes as late as the limits allow, or brakes
+	// right away when s_stop is too short
+	static VelocityProfile toStop(double v0, double a0, double s_stop, double a_max, double j_max);
+
+	// time until the final speed is reached, distance covered until then
+	double duration() const { return phases_[num_phases_].t0; }
+	double distance() const { return phases_[num_phases_].s0; }
+	double finalSpeed() const { return phases_[num_phases_].v0; }
+
+	// state t seconds after the start
+	void sample(double t, double &s, double &v, double &a) const;
+	// states at t0 + i*dt for i in [0, n), one branch-free loop per phase
+	void sample(double t0, double dt, int n, double *s, double *v, double *a) const;
+
+private:
+	struct Phase
+	{
+		double t0;
+		double s0;
+		double v0;
+		double a0;
+		double jerk;
+	};
+
+	// ramp out a0, constant a, ramp in: at most 2 of these back to back
+	static const int kMaxPhases = 7;
+
+	VelocityProfile(double v0, double a0);
+	void append(double duration, double jerk);
+	void appendSpeedChange(double v_target, double a_max, double j_max);
+	// ends in a constant speed phase
+	void finish();
+
+	// phases_[num_phases_] is the final constant speed phase
+	Phase phases_[kMaxPhases + 1];
+	int num_phases_ = 0;
+};
+
+#endif /* VELOCITY_PROFILE_H */
@@ -0,0 +1,234 @@
+#include "waypoint_map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+static const size_t kCacheLine = 64;
+
+static size_t alignUp(size_t n)
+{
+	return (n + kCacheLine - 1) & ~(kCacheLine - 1);
+}
+
+shared_ptr<const WaypointMap> WaypointMap::fromFile(const string &path, double max_s)
+{
+	ifstream in_map_(path.c_str(), ifstream::in);
+	return fromStream(in_map_, max_s);
+}
+
+shared_ptr<const WaypointMap> WaypointMap::fromStream(istream &in_map_, double max_s)
+{
+	vector<double> maps_x;
+	vector<double> maps_y;
+	vector<double> maps_s;
+	vector<double> maps_dx;
+	vector<double> maps_dy;
+
+	string line;
+	while (getline(in_map_, line))
+	{
+		istringstream iss(line);
+		double x;
+		double y;
+		float s;
+		float d_x;
+		float d_y;
+		iss >> x;
+		iss >> y;
+		iss >> s;
+		iss >> d_x;
+		iss >> d_y;
+		maps_x.push_back(x);
+		maps_y.push_back(y);
+		maps_s.push_back(s);
+		maps_dx.push_back(d_x);
+		maps_dy.push_back(d_y);
+	}
+
+	return fromWaypoints(maps_x, maps_y, maps_s, maps_dx, maps_dy, max_s);
+}
+
+shared_ptr<const WaypointMap> WaypointMap::fromWaypoints(const vector<double> &maps_x, const vector<double> &maps_y,
+														 const vector<double> &maps_s, const vector<double> &maps_dx,
+														 const vector<double> &maps_dy, double max_s)
+{
+	shared_ptr<WaypointMap> map(new WaypointMap());
+	int n = maps_x.size();
+	map->size_ = n;
+	map->max_s_ = max_s;
+	if (n == 0)
+	{
+		return map;
+	}
+
+	size_t waypoints_bytes = alignUp(n * sizeof(Waypoint));
+	size_t xy_bytes = alignUp(2 * n * sizeof(double));
+	size_t s_bytes = alignUp(n * sizeof(double));
+
+	void *block = nullptr;
+	if (posix_memalign(&block, kCacheLine, waypoints_bytes + xy_bytes + s_bytes) != 0)
+	{
+		throw bad_alloc();
+	}
+	map->storage_ = shared_ptr<const void>(block, free);
+
+	char *base = static_cast<char *>(block);
+	Waypoint *waypoints = reinterpret_cast<Waypoint *>(base);
+	double *xy = reinterpret_cast<double *>(base + waypoints_bytes);
+	double *s = reinterpret_cast<double *>(base + waypoints_bytes + xy_bytes);
+
+	double frenet_s = 0.0;
+	for (int i = 0; i < n; i++)
+	{
+		int next = (i + 1) % n;
+		double heading = atan2(maps_y[next] - maps_y[i], maps_x[next] - maps_x[i]);
+
+		Waypoint &wp = waypoints[i];
+		wp.x = maps_x[i];
+		wp.y = maps_y[i];
+		wp.s = maps_s[i];
+		wp.dx = maps_dx[i];
+		wp.dy = maps_dy[i];
+		wp.cos_heading = cos(heading);
+		wp.sin_heading = sin(heading);
+		wp.frenet_s = frenet_s;
+		frenet_s += sqrt((maps_x[next] - maps_x[i]) * (maps_x[next] - maps_x[i]) + (maps_y[next] - maps_y[i]) * (maps_y[next] - maps_y[i]));
+
+		xy[2 * i] = maps_x[i];
+		xy[2 * i + 1] = maps_y[i];
+		s[i] = maps_s[i];
+	}
+
+	map->waypoints_ = waypoints;
+	map->xy_ = xy;
+	map->s_ = s;
+	MapBuildParams params;
+	map->profile_ = RoadProfile(maps_x, maps_y, maps_s, max_s, params.v_max, params.a_lat_max, params.a_brake,
+								params.num_lanes, params.lane_width, params.ds);
+
+	return map;
+}
+
+int WaypointMap::closestWaypoint(double x, double y) const
+{
+	// squared distances keep the same ordering without a sqrt per waypoint
+	double closestLen = 1e10; //large number
+	int closestWaypoint = 0;
+
+	for (int i = 0; i < size_; i++)
+	{
+		double dx = xy_[2 * i] - x;
+		double dy = xy_[2 * i + 1] - y;
+		double dist = dx * dx + dy * dy;
+		if (dist < closestLen)
+		{
+			closestLen = dist;
+			closestWaypoint = i;
+		}
+	}
+
+	return closestWaypoint;
+}
+
+int WaypointMap::nextWaypoint(double x, double y, double theta) const
+{
+	int closestWaypoint = this->closestWaypoint(x, y);
+
+	double map_x = xy_[2 * closestWaypoint];
+	double map_y = xy_[2 * closestWaypoint + 1];
+
+	double heading = atan2((map_y - y), (map_x - x));
+
+	double angle = fabs(theta - heading);
+	angle = min(2 * M_PI - angle, angle);
+
+	if (angle > M_PI / 4)
+	{
+		closestWaypoint++;
+		if (closestWaypoint == size_)
+		{
+			closestWaypoint = 0;
+		}
+	}
+
+	return closestWaypoint;
+}
+
+vector<double> WaypointMap::getFrenet(double x, double y, double theta) const
+{
+	vector<double> sd(2);
+	getFrenet(x, y, theta, sd[0], sd[1]);
+	return sd;
+}
+
+void WaypointMap::getFrenet(double x, double y, double theta, double &s, double &d) const
+{
+	int next_wp = nextWaypoint(x, y, theta);
+	int prev_wp = (next_wp == 0) ? size_ - 1 : next_wp - 1;
+
+	const Waypoint &prev = waypoints_[prev_wp];
+	const Waypoint &next = waypoints_[next_wp];
+
+	double n_x = next.x - prev.x;
+	double n_y = next.y - prev.y;
+	double x_x = x - prev.x;
+	double x_y = y - prev.y;
+
+	// find the projection of x onto n
+	double proj_norm = (x_x * n_x + x_y * n_y) / (n_x * n_x + n_y * n_y);
+	double proj_x = proj_norm * n_x;
+	double proj_y = proj_norm * n_y;
+
+	double frenet_d = sqrt((x_x - proj_x) * (x_x - proj_x) + (x_y - proj_y) * (x_y - proj_y));
+
+	//see if d value is positive or negative by comparing it to a center point
+	double center_x = 1000 - prev.x;
+	double center_y = 2000 - prev.y;
+	double centerToPos = sqrt((center_x - x_x) * (center_x - x_x) + (center_y - x_y) * (center_y - x_y));
+	double centerToRef = sqrt((center_x - proj_x) * (center_x - proj_x) + (center_y - proj_y) * (center_y - proj_y));
+
+	if (centerToPos <= centerToRef)
+	{
+		frenet_d *= -1;
+	}
+
+	s = prev.frenet_s + sqrt(proj_x * proj_x + proj_y * proj_y);
+	d = frenet_d;
+}
+
+vector<double> WaypointMap::getXY(double s, double d) const
+{
+	vector<double> xy(2);
+	getXY(s, d, xy[0], xy[1]);
+	return xy;
+}
+
+void WaypointMap::getXY(double s, double d, double &x, double &y) const
+{
+	s = fmod(s, max_s_);
+	if (s < 0)
+	{
+		s += max_s_;
+	}
+
+	// last waypoint with s_ <= s
+	int prev_wp = int(upper_bound(s_, s_ + size_, s) - s_) - 1;
+	prev_wp = max(prev_wp, 0);
+
+	const Waypoint &wp = waypoints_[prev_wp];
+
+	// the x,y,s along the segment
+	double seg_s = (s - wp.s);
+
+	double seg_x = wp.x + seg_s * wp.cos_heading;
+	double seg_y = wp.y + seg_s * wp.sin_heading;
+
+	// perpendicular heading is heading - pi/2
+	x = seg_x + d * wp.sin_heading;
+	y = seg_y - d * wp.cos_heading;
+}
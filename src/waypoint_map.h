@@ -0,0 +1,106 @@
+#ifndef WAYPOINT_MAP_H
+#define WAYPOINT_MAP_H
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "road_profile.h"
+
+// Everything getXY/getFrenet read about one waypoint and the segment that
+// starts at it, packed into a single cache line.
+struct alignas(64) Waypoint
+{
+	double x;
+	double y;
+	double s;
+	double dx;
+	double dy;
+	// heading of the segment towards the next waypoint
+	double cos_heading;
+	double sin_heading;
+	// euclidean length of the polyline from waypoint 0 up to this one
+	double frenet_s;
+};
+
+static_assert(sizeof(Waypoint) == 64, "Waypoint must fill exactly one cache line");
+
+// Parameters the derived tables are built with
+struct MapBuildParams
+{
+	// speed limit the per-lane curve limits are capped at
+	double v_max = 48.0 * 0.44704;
+	double a_lat_max = 3.0;
+	double a_brake = 2.0;
+	int num_lanes = 3;
+	double lane_width = 4.0;
+	// road profile sample spacing along s
+	double ds = 1.0;
+};
+
+// Immutable waypoint map. All tables live in one cache-line aligned block:
+//  - one Waypoint record per line for the segment lookups,
+//  - packed x,y pairs for the linear ClosestWaypoint scan,
+//  - packed s values for the getXY search.
+// Instances are only handed out as shared_ptr<const WaypointMap>, so any
+// number of threads and connections can read the same map without locking.
+class WaypointMap
+{
+public:
+	static std::shared_ptr<const WaypointMap> fromFile(const std::string &path, double max_s);
+	static std::shared_ptr<const WaypointMap> fromStream(std::istream &in, double max_s);
+	// Like fromFile, but the derived tables are memory-mapped from path + ".cache"
+	// when it was built from the same CSV contents and parameters, and the
+	// cache is (re)written otherwise.
+	static std::shared_ptr<const WaypointMap> fromFileCached(const std::string &path, double max_s);
+	static std::shared_ptr<const WaypointMap> fromWaypoints(const std::vector<double> &maps_x, const std::vector<double> &maps_y,
+															const std::vector<double> &maps_s, const std::vector<double> &maps_dx,
+															const std::vector<double> &maps_dy, double max_s);
+#ifdef EMBEDDED_MAP
+	// map compiled into the binary from the generated embedded_map_data.h,
+	// no file I/O and the tables stay in read-only pages
+	static std::shared_ptr<const WaypointMap> embedded();
+#endif
+
+	WaypointMap(const WaypointMap &) = delete;
+	WaypointMap &operator=(const WaypointMap &) = delete;
+
+	int size() const { return size_; }
+	double maxS() const { return max_s_; }
+	const Waypoint &operator[](int i) const { return waypoints_[i]; }
+	const RoadProfile &profile() const { return profile_; }
+
+	// raw tables, used to serialize the map
+	const Waypoint *waypoints() const { return waypoints_; }
+	const double *xyTable() const { return xy_; }
+	const double *sTable() const { return s_; }
+
+	int closestWaypoint(double x, double y) const;
+	int nextWaypoint(double x, double y, double theta) const;
+
+	// Transform from Cartesian x,y coordinates to Frenet s,d coordinates
+	std::vector<double> getFrenet(double x, double y, double theta) const;
+	// Transform from Frenet s,d coordinates to Cartesian x,y
+	std::vector<double> getXY(double s, double d) const;
+	// the same without allocating, for the planner's hot path
+	void getFrenet(double x, double y, double theta, double &s, double &d) const;
+	void getXY(double s, double d, double &x, double &y) const;
+
+private:
+	WaypointMap() {}
+
+	static std::shared_ptr<const WaypointMap> fromCache(const std::string &cache_path, unsigned long long key);
+	static bool writeCache(const WaypointMap &map, const std::string &cache_path, unsigned long long key);
+
+	// null when the tables are static data
+	std::shared_ptr<const void> storage_;
+	const Waypoint *waypoints_ = nullptr;
+	const double *xy_ = nullptr;
+	const double *s_ = nullptr;
+	int size_ = 0;
+	double max_s_ = 0.0;
+	RoadProfile profile_;
+};
+
+#endif /* WAYPOINT_MAP_H */
@@ -0,0 +1,79 @@
+// behavior_fsm: the expanded table agrees with the transition rows for every
+// state and input, a lane change is prepared until its gap is safe and then
+// finished before anything else is considered.
+#include "behavior_fsm.h"
+#include "test_check.h"
+
+using namespace behavior_fsm;
+
+static void testTableMatchesRows()
+{
+	for (unsigned state = 0; state < kNumStates; state++)
+	{
+		for (unsigned inputs = 0; inputs < kNumInputs; inputs++)
+		{
+			CHECK(step(State(state), inputs) == transition(state, inputs));
+		}
+	}
+	// bits above the inputs are ignored
+	CHECK(step(KeepLane, kNumInputs | kPreferRight) == PrepareLaneChangeRight);
+}
+
+static void testKeepLane()
+{
+	CHECK(step(KeepLane, 0) == KeepLane);
+	CHECK(step(KeepLane, kLeftSafe | kRightSafe | kInTargetLane) == KeepLane);
+	CHECK(step(KeepLane, kPreferLeft) == PrepareLaneChangeLeft);
+	CHECK(step(KeepLane, kPreferRight) == PrepareLaneChangeRight);
+	// rows are tried in order
+	CHECK(step(KeepLane, kPreferLeft | kPreferRight) == PrepareLaneChangeLeft);
+}
+
+static void testLaneChangeLeft()
+{
+	// waits for the gap while the left lane is still better
+	State state = step(KeepLane, kPreferLeft);
+	state = step(state, kPreferLeft | kRightSafe);
+	CHECK(state == PrepareLaneChangeLeft);
+	state = step(state, kPreferLeft | kLeftSafe);
+	CHECK(state == LaneChangeLeft);
+	CHECK(kLaneOffset[state] == -1);
+	CHECK(kDecision[state] == -1);
+	// no longer preferred or safe, the change still finishes
+	state = step(state, kPreferRight);
+	CHECK(state == LaneChangeLeft);
+	state = step(state, kInTargetLane);
+	CHECK(state == KeepLane);
+}
+
+static void testLaneChangeRight()
+{
+	State state = step(KeepLane, kPreferRight);
+	state = step(state, kPreferRight | kRightSafe);
+	CHECK(state == LaneChangeRight);
+	CHECK(kLaneOffset[state] == 1);
+	CHECK(kDecision[state] == 1);
+	CHECK(step(state, kPreferLeft | kLeftSafe) == LaneChangeRight);
+	CHECK(step(state, kInTargetLane) == KeepLane);
+}
+
+static void testPrepareAborts()
+{
+	// the other lane stopped being better, safe or not
+	CHECK(step(PrepareLaneChangeLeft, kLeftSafe) == KeepLane);
+	CHECK(step(PrepareLaneChangeRight, kRightSafe) == KeepLane);
+	CHECK(step(PrepareLaneChangeLeft, kPreferRight | kRightSafe) == KeepLane);
+	// preparing changes nothing yet
+	CHECK(kLaneOffset[PrepareLaneChangeLeft] == 0);
+	CHECK(kLaneOffset[PrepareLaneChangeRight] == 0);
+}
+
+int main()
+{
+	testTableMatchesRows();
+	testKeepLane();
+	testLaneChangeLeft();
+	testLaneChangeRight();
+	testPrepareAborts();
+	return testResult();
+}
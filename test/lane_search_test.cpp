@@ -0,0 +1,95 @@
+// LaneSearch: the lookahead leaves a lane blocked by a slow leader for a free
+// one, never into a car alongside, merges equivalent states, and when it is
+// pruned by its node or time budget still answers from complete levels.
+#include <vector>
+
+#include "lane_search.h"
+#include "test_check.h"
+#include "test_scene.h"
+
+using namespace std;
+
+static const double kSpeed = 20.0;
+
+static SearchParams generousParams()
+{
+	SearchParams params;
+	params.budget_ms = 1000.0;
+	return params;
+}
+
+static void testFreeRoad()
+{
+	TrafficPrediction prediction;
+	prediction.update({});
+	LaneSearch search(3, generousParams());
+	const SearchResult &result = search.search(kCarS, 1, kSpeed, prediction);
+	CHECK(result.lane == 1);
+	CHECK(result.depth == search.params().max_depth);
+	CHECK(!result.deadline_hit);
+	// staying or changing back and forth end in the same states
+	CHECK(result.transpositions > 0);
+	CHECK(result.nodes <= search.params().max_nodes);
+}
+
+static void testLeavesSlowLeader()
+{
+	TrafficPrediction prediction;
+	prediction.update({car(0, 1, kCarS + 20.0, 5.0)});
+	LaneSearch search(3, generousParams());
+	const SearchResult &result = search.search(kCarS, 1, kSpeed, prediction);
+	CHECK(result.lane != 1);
+	CHECK(!result.deadline_hit);
+}
+
+static void testAvoidsCarAlongside()
+{
+	TrafficPrediction prediction;
+	prediction.update({car(0, 1, kCarS + 20.0, 5.0), car(1, 0, kCarS + 1.0, kSpeed)});
+	LaneSearch search(3, generousParams());
+	CHECK(search.search(kCarS, 1, kSpeed, prediction).lane == 2);
+
+	// the mirror image
+	prediction.update({car(0, 1, kCarS + 20.0, 5.0), car(1, 2, kCarS - 1.0, kSpeed)});
+	CHECK(search.search(kCarS, 1, kSpeed, prediction).lane == 0);
+}
+
+static void testNodeBudget()
+{
+	TrafficPrediction prediction;
+	prediction.update({car(0, 1, kCarS + 20.0, 5.0)});
+	SearchParams params = generousParams();
+	params.max_nodes = 40;
+	LaneSearch search(3, params);
+	const SearchResult &result = search.search(kCarS, 1, kSpeed, prediction);
+	CHECK(result.deadline_hit);
+	CHECK(result.depth >= 1);
+	CHECK(result.depth < params.max_depth);
+	CHECK(result.nodes <= params.max_nodes);
+	// even one level sees that staying behind the leader is worse
+	CHECK(result.lane != 1);
+}
+
+static void testTimeBudget()
+{
+	TrafficPrediction prediction;
+	prediction.update({car(0, 1, kCarS + 20.0, 5.0)});
+	SearchParams params;
+	params.budget_ms = 0.0;
+	LaneSearch search(3, params);
+	const SearchResult &result = search.search(kCarS, 1, kSpeed, prediction);
+	// nothing expanded: the current lane
+	CHECK(result.deadline_hit);
+	CHECK(result.depth == 0);
+	CHECK(result.lane == 1);
+}
+
+int main()
+{
+	testFreeRoad();
+	testLeavesSlowLeader();
+	testAvoidsCarAlongside();
+	testNodeBudget();
+	testTimeBudget();
+	return testResult();
+}
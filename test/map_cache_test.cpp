@@ -0,0 +1,124 @@
+// Map cache: fromFileCached builds the same map as fromFile, writes the
+// cache and reuses it, and rebuilds it when the CSV changes or the file's
+// header, key or size does not check out.
+//
+//   map_cache_test <highway_map.csv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "test_check.h"
+#include "waypoint_map.h"
+
+using namespace std;
+
+static const double kMaxS = 6945.554;
+// written next to the test, in the working directory
+static const string kCsv = "map_cache_test.csv";
+static const string kCache = kCsv + ".cache";
+
+static string readFile(const string &path)
+{
+	ifstream in(path.c_str(), ifstream::in | ifstream::binary);
+	ostringstream contents;
+	contents << in.rdbuf();
+	return contents.str();
+}
+
+static void writeFile(const string &path, const string &contents)
+{
+	ofstream out(path.c_str(), ofstream::out | ofstream::binary | ofstream::trunc);
+	out << contents;
+}
+
+static bool sameMap(const WaypointMap &a, const WaypointMap &b)
+{
+	if (a.size() != b.size() || a.maxS() != b.maxS() || a.profile().size() != b.profile().size() ||
+		a.profile().numLanes() != b.profile().numLanes())
+	{
+		return false;
+	}
+	int n = a.size();
+	int m = a.profile().size();
+	return memcmp(a.waypoints(), b.waypoints(), n * sizeof(Waypoint)) == 0 &&
+		   memcmp(a.xyTable(), b.xyTable(), 2 * n * sizeof(double)) == 0 &&
+		   memcmp(a.sTable(), b.sTable(), n * sizeof(double)) == 0 &&
+		   memcmp(a.profile().speedLimitTable(), b.profile().speedLimitTable(),
+				  a.profile().numLanes() * m * sizeof(double)) == 0;
+}
+
+// loads through the cache and checks the result against the CSV itself
+static void checkLoad(const char *what)
+{
+	shared_ptr<const WaypointMap> cached = WaypointMap::fromFileCached(kCsv, kMaxS);
+	shared_ptr<const WaypointMap> direct = WaypointMap::fromFile(kCsv, kMaxS);
+	if (!sameMap(*cached, *direct))
+	{
+		cerr << what << ": cached map differs from the CSV" << endl;
+		test_failures++;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		cerr << "Usage: " << argv[0] << " <highway_map.csv>" << endl;
+		return 2;
+	}
+	const string csv = readFile(argv[1]);
+	CHECK(!csv.empty());
+	writeFile(kCsv, csv);
+	remove(kCache.c_str());
+
+	// first load writes the cache, the second maps it
+	checkLoad("no cache");
+	const string image = readFile(kCache);
+	CHECK(!image.empty());
+	checkLoad("valid cache");
+	CHECK(readFile(kCache) == image);
+
+	// a different CSV has a different key: not served from the stale cache
+	string edited = csv;
+	// one more digit in the first x
+	size_t space = edited.find(' ');
+	CHECK(space != string::npos);
+	edited.insert(space, "5");
+	writeFile(kCsv, edited);
+	checkLoad("edited CSV");
+	CHECK(readFile(kCache) != image);
+	writeFile(kCsv, csv);
+	checkLoad("original CSV");
+	CHECK(readFile(kCache) == image);
+
+	// corrupted headers are rejected and the cache is rewritten
+	struct Corruption
+	{
+		const char *what;
+		size_t offset;
+	};
+	// magic, version, header size, key, file size
+	const Corruption corruptions[] = {{"magic", 0}, {"version", 8}, {"header size", 12}, {"key", 16}, {"file size", 24}};
+	for (const Corruption &corruption : corruptions)
+	{
+		string broken = image;
+		broken[corruption.offset] ^= 0x5a;
+		writeFile(kCache, broken);
+		checkLoad(corruption.what);
+		CHECK(readFile(kCache) == image);
+	}
+
+	// truncated tables, and a file shorter than its header
+	writeFile(kCache, image.substr(0, image.size() / 2));
+	checkLoad("truncated");
+	CHECK(readFile(kCache) == image);
+	writeFile(kCache, image.substr(0, 16));
+	checkLoad("header only");
+	CHECK(readFile(kCache) == image);
+
+	remove(kCache.c_str());
+	remove(kCsv.c_str());
+	return testResult();
+}
@@ -0,0 +1,137 @@
+// SpeedPlanner: on a free road the plan speeds up to the limit, behind a slow
+// leader it keeps s_min behind its rear, every step within the acceleration
+// and jerk limits, and a leader already too close leaves no plan.
+#include <algorithm>
+#include <vector>
+
+#include "speed_planner.h"
+#include "test_check.h"
+#include "test_scene.h"
+
+using namespace std;
+
+static const double kLimit = 22.0;
+
+// accelerations and jerks between the step speeds, from v0 and a0 on; the
+// speeds sit on s bins, so allow one bin of rounding per step
+static void checkLimits(const SpeedPlannerParams &p, const SpeedProfile &profile, double v0, double a0)
+{
+	double slack = p.s_res / (p.dt * p.dt);
+	double v = v0;
+	double a = a0;
+	for (double next : profile.v)
+	{
+		double a_next = (next - v) / p.dt;
+		CHECK(a_next <= p.a_max + slack);
+		CHECK(a_next >= p.a_min - slack);
+		CHECK(fabs(a_next - a) / p.dt <= p.j_max + slack / p.dt);
+		CHECK(next >= 0.0);
+		CHECK(next <= kLimit);
+		v = next;
+		a = a_next;
+	}
+}
+
+static void testFreeRoad()
+{
+	TrafficPrediction prediction;
+	prediction.update({});
+	SpeedPlanner planner;
+	SpeedProfile profile;
+	CHECK(planner.plan(kCarS, 10.0, 0.0, kLimit, 1, 0.0, prediction, profile));
+	CHECK(profile.feasible);
+	CHECK((int)profile.v.size() == planner.params().steps);
+	CHECK_NEAR(profile.dt, planner.params().dt, 1e-12);
+	checkLimits(planner.params(), profile, 10.0, 0.0);
+	// speeds up all the way
+	for (size_t k = 1; k < profile.v.size(); k++)
+	{
+		CHECK(profile.v[k] >= profile.v[k - 1]);
+	}
+	CHECK(profile.v.back() > 18.0);
+
+	// cars in the other lanes change nothing
+	prediction.update({car(0, 0, kCarS + 10.0, 0.0), car(1, 2, kCarS + 10.0, 0.0)});
+	SpeedProfile other;
+	CHECK(planner.plan(kCarS, 10.0, 0.0, kLimit, 1, 0.0, prediction, other));
+	CHECK(other.v == profile.v);
+}
+
+static void testSlowLeader()
+{
+	const double gap = 40.0;
+	const double leader_speed = 5.0;
+	TrafficPrediction prediction;
+	prediction.update({car(0, 1, kCarS + gap, leader_speed)});
+	SpeedPlanner planner;
+	const SpeedPlannerParams &p = planner.params();
+	SpeedProfile profile;
+	CHECK(planner.plan(kCarS, 15.0, 0.0, kLimit, 1, 0.0, prediction, profile));
+	checkLimits(p, profile, 15.0, 0.0);
+	double s = 0.0;
+	for (int k = 0; k < (int)profile.v.size(); k++)
+	{
+		s += profile.v[k] * p.dt;
+		double rear = gap + leader_speed * (k + 1) * p.dt - p.car_length;
+		CHECK(s <= rear - p.s_min + 1e-9);
+	}
+	// slows down towards the leader's speed
+	CHECK(profile.v.back() < 15.0);
+
+	// without the headway cost only the blocked cells hold it back
+	SpeedPlannerParams params;
+	params.w_headway = 0.0;
+	SpeedPlanner pushy(params);
+	CHECK(pushy.plan(kCarS, 15.0, 0.0, kLimit, 1, 0.0, prediction, profile));
+	checkLimits(params, profile, 15.0, 0.0);
+	s = 0.0;
+	double closest = gap;
+	for (int k = 0; k < (int)profile.v.size(); k++)
+	{
+		s += profile.v[k] * params.dt;
+		double rear = gap + leader_speed * (k + 1) * params.dt - params.car_length;
+		CHECK(s <= rear - params.s_min + 1e-9);
+		closest = min(closest, rear - s);
+	}
+	// and it closes up to the bound
+	CHECK(closest < params.s_min + 1.0);
+}
+
+static void testBlocked()
+{
+	SpeedPlanner planner;
+	const SpeedPlannerParams &p = planner.params();
+	TrafficPrediction prediction;
+	SpeedProfile profile;
+	// closer than s_min already
+	prediction.update({car(0, 1, kCarS + p.car_length + p.s_min - 1.0, 20.0)});
+	CHECK(!planner.plan(kCarS, 20.0, 0.0, kLimit, 1, 0.0, prediction, profile));
+	CHECK(!profile.feasible);
+	// a stopped car ahead that even the hardest braking cannot stop for
+	prediction.update({car(0, 1, kCarS + 15.0, 0.0)});
+	CHECK(!planner.plan(kCarS, 20.0, 0.0, kLimit, 1, 0.0, prediction, profile));
+	CHECK(!profile.feasible);
+}
+
+static void testSpeedAt()
+{
+	SpeedProfile profile;
+	CHECK_NEAR(profile.speedAt(1.0), 0.0, 1e-12);
+	profile.dt = 0.5;
+	profile.v = {10.0, 12.0, 16.0};
+	// the middles of the steps, between them, and clamped at both ends
+	CHECK_NEAR(profile.speedAt(0.25), 10.0, 1e-12);
+	CHECK_NEAR(profile.speedAt(0.75), 12.0, 1e-12);
+	CHECK_NEAR(profile.speedAt(1.0), 14.0, 1e-12);
+	CHECK_NEAR(profile.speedAt(0.0), 10.0, 1e-12);
+	CHECK_NEAR(profile.speedAt(5.0), 16.0, 1e-12);
+}
+
+int main()
+{
+	testFreeRoad();
+	testSlowLeader();
+	testBlocked();
+	testSpeedAt();
+	return testResult();
+}
@@ -0,0 +1,49 @@
+// tk::spline::eval: the batch values and derivatives match operator() and
+// deriv() point by point, for ascending x walking the pieces once as well as
+// for x in any order, on the knots and outside them.
+#include <vector>
+
+#include "spline.h"
+#include "test_check.h"
+
+using namespace std;
+
+static void checkEval(const tk::spline &sp, const vector<double> &x)
+{
+	int n = x.size();
+	vector<double> y(n), dy(n), ddy(n);
+	sp.eval(x.data(), n, y.data(), dy.data(), ddy.data());
+	for (int i = 0; i < n; i++)
+	{
+		CHECK_NEAR(y[i], sp(x[i]), 1e-12);
+		CHECK_NEAR(dy[i], sp.deriv(1, x[i]), 1e-12);
+		CHECK_NEAR(ddy[i], sp.deriv(2, x[i]), 1e-12);
+	}
+	// outputs left out
+	vector<double> y_only(n);
+	sp.eval(x.data(), n, y_only.data(), nullptr, nullptr);
+	CHECK(y_only == y);
+}
+
+int main()
+{
+	vector<double> knots = {0.0, 1.0, 2.5, 3.0, 5.0, 8.0};
+	vector<double> values = {0.0, 2.0, 1.0, 1.5, 4.0, 3.0};
+	tk::spline sp;
+	sp.set_points(knots, values);
+
+	// ascending, through every piece, both extrapolations and the knots
+	vector<double> ascending;
+	for (double x = -2.0; x <= 10.0; x += 0.25)
+	{
+		ascending.push_back(x);
+	}
+	checkEval(sp, ascending);
+	checkEval(sp, knots);
+
+	// descending and mixed
+	vector<double> descending(ascending.rbegin(), ascending.rend());
+	checkEval(sp, descending);
+	checkEval(sp, {4.0, 0.5, 8.0, 2.5, 2.5, -1.0, 9.0, 1.0, 3.0});
+	return testResult();
+}
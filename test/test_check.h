@@ -0,0 +1,45 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <cmath>
+#include <iostream>
+
+// Minimal checks for the test executables: a failed check prints where and
+// what failed and the test goes on, main returns testResult().
+static int test_failures = 0;
+
+#define CHECK(condition)                                                                 \
+	do                                                                                   \
+	{                                                                                    \
+		if (!(condition))                                                                \
+		{                                                                                \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" \
+					  << std::endl;                                                      \
+			test_failures++;                                                             \
+		}                                                                                \
+	} while (0)
+
+#define CHECK_NEAR(a, b, tolerance)                                                                  \
+	do                                                                                               \
+	{                                                                                                \
+		double check_a = (a);                                                                        \
+		double check_b = (b);                                                                        \
+		if (!(std::fabs(check_a - check_b) <= (tolerance)))                                          \
+		{                                                                                            \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_NEAR(" #a ", " #b ") failed: " << check_a \
+					  << " vs " << check_b << std::endl;                                             \
+			test_failures++;                                                                         \
+		}                                                                                            \
+	} while (0)
+
+static int testResult()
+{
+	if (test_failures > 0)
+	{
+		std::cerr << test_failures << " checks failed" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+#endif /* TEST_CHECK_H */
@@ -0,0 +1,16 @@
+#ifndef TEST_SCENE_H
+#define TEST_SCENE_H
+
+#include <vector>
+
+// Traffic for the tests on a straight road along x, where s is x and lane l
+// is centred on d = 2 + 4 l. The ego car is at kCarS.
+static const double kCarS = 100.0;
+
+// sensor fusion row of a car in lane at s, moving along x at speed
+inline std::vector<double> car(int id, int lane, double s, double speed)
+{
+	return {(double)id, s, 0.0, speed, 0.0, s, 2.0 + 4.0 * lane};
+}
+
+#endif /* TEST_SCENE_H */
@@ -0,0 +1,136 @@
+// TrajectoryBuffer: resync against the simulator's previous path, across the
+// wrap-around of the ring, and the cases in which it has to give up.
+#include <vector>
+
+#include "test_check.h"
+#include "trajectory_buffer.h"
+
+using namespace std;
+
+// the k-th point ever emitted
+static TrajectoryPoint point(int k)
+{
+	TrajectoryPoint p = {1.0 * k, 2.0 * k, 0.5 * k, 6.0, 20.0, 0.0, 0.0};
+	return p;
+}
+
+// what the simulator echoes back: the points from first on, rounded as if
+// they went through JSON
+static void previousPath(const TrajectoryBuffer &buffer, int first, vector<double> &x, vector<double> &y)
+{
+	x.clear();
+	y.clear();
+	for (int i = first; i < buffer.size(); i++)
+	{
+		x.push_back(buffer[i].x + 1e-5);
+		y.push_back(buffer[i].y - 1e-5);
+	}
+}
+
+static void testResyncDropsConsumed()
+{
+	TrajectoryBuffer buffer;
+	for (int k = 0; k < 50; k++)
+	{
+		CHECK(buffer.push(point(k)));
+	}
+	vector<double> x, y;
+	previousPath(buffer, 3, x, y);
+	CHECK(buffer.resync(x, y));
+	CHECK(buffer.size() == 47);
+	CHECK(buffer[0].x == 3.0);
+	CHECK(buffer[46].x == 49.0);
+}
+
+static void testResyncAcrossWrapAround()
+{
+	// frames of 50 points, the simulator drives 1 to 7 of them in between,
+	// so head moves around the ring many times
+	TrajectoryBuffer buffer;
+	int next = 0;
+	int first = 0;
+	vector<double> x, y;
+	for (int frame = 0; frame < 200; frame++)
+	{
+		while (buffer.size() < 50)
+		{
+			CHECK(buffer.push(point(next++)));
+		}
+		int consumed = 1 + frame % 7;
+		previousPath(buffer, consumed, x, y);
+		CHECK(buffer.resync(x, y));
+		first += consumed;
+		CHECK(buffer.size() == 50 - consumed);
+		for (int i = 0; i < buffer.size(); i++)
+		{
+			CHECK(buffer[i].x == first + i);
+		}
+	}
+}
+
+static void testResyncGivesUp()
+{
+	TrajectoryBuffer buffer;
+	for (int k = 0; k < 50; k++)
+	{
+		buffer.push(point(k));
+	}
+	vector<double> x, y;
+
+	// nothing left of the path
+	TrajectoryBuffer copy = buffer;
+	CHECK(!copy.resync(x, y));
+	CHECK(copy.empty());
+
+	// a previous path longer than what was sent
+	previousPath(buffer, 0, x, y);
+	x.push_back(50.0);
+	y.push_back(100.0);
+	copy = buffer;
+	CHECK(!copy.resync(x, y));
+	CHECK(copy.empty());
+
+	// the tail of another path, e.g. after a lost reply
+	previousPath(buffer, 5, x, y);
+	x.back() += 0.5;
+	copy = buffer;
+	CHECK(!copy.resync(x, y));
+	CHECK(copy.empty());
+
+	// the first point off by more than the JSON rounding
+	previousPath(buffer, 5, x, y);
+	y.front() += 0.01;
+	copy = buffer;
+	CHECK(!copy.resync(x, y));
+	CHECK(copy.empty());
+}
+
+static void testPushTruncateShift()
+{
+	TrajectoryBuffer buffer;
+	for (int k = 0; k < TrajectoryBuffer::kCapacity; k++)
+	{
+		CHECK(buffer.push(point(k)));
+	}
+	CHECK(!buffer.push(point(TrajectoryBuffer::kCapacity)));
+	CHECK(buffer.size() == TrajectoryBuffer::kCapacity);
+
+	buffer.truncate(10);
+	CHECK(buffer.size() == 10);
+	buffer.truncate(20);
+	CHECK(buffer.size() == 10);
+	buffer.shiftS(1.5);
+	CHECK(buffer[0].s == 1.5);
+	CHECK(buffer[9].s == 6.0);
+	buffer.truncate(-1);
+	CHECK(buffer.empty());
+}
+
+int main()
+{
+	testResyncDropsConsumed();
+	testResyncAcrossWrapAround();
+	testResyncGivesUp();
+	testPushTruncateShift();
+	return testResult();
+}
@@ -0,0 +1,125 @@
+// VelocityProfile: the S-curve segments reach their target within the
+// acceleration and jerk limits, batch sampling matches single samples, and
+// toStop stops at the requested position or as early as the limits allow.
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "test_check.h"
+#include "velocity_profile.h"
+
+using namespace std;
+
+static const double kAMax = 5.0;
+static const double kJMax = 5.0;
+
+// samples the profile finely past its end and checks the limits on the way;
+// a0 beyond kAMax is only ramped down
+static void checkLimits(const VelocityProfile &profile, double a0)
+{
+	double dt = 1e-3;
+	double a_limit = max(kAMax, fabs(a0)) + 1e-6;
+	double s_last, v_last, a_last;
+	profile.sample(0.0, s_last, v_last, a_last);
+	for (double t = dt; t < profile.duration() + 1.0; t += dt)
+	{
+		double s, v, a;
+		profile.sample(t, s, v, a);
+		CHECK(fabs(a) <= a_limit);
+		// a is piecewise linear, a kink between the samples only lowers it
+		CHECK(fabs(a - a_last) <= kJMax * dt + 1e-9);
+		// position and speed are continuous across the phases
+		CHECK(fabs(v - v_last) <= a_limit * dt + 1e-9);
+		CHECK(fabs(s - s_last) <= max(fabs(v), fabs(v_last)) * dt + 1e-9);
+		s_last = s;
+		v_last = v;
+		a_last = a;
+	}
+}
+
+static void testToSpeed()
+{
+	for (double v0 : {0.0, 5.0, 15.0, 22.0})
+	{
+		for (double a0 : {-4.0, -1.0, 0.0, 1.0, 4.0})
+		{
+			for (double v_target : {0.0, 10.0, 22.0})
+			{
+				if (v0 == 0.0 && a0 < 0.0)
+				{
+					continue;
+				}
+				VelocityProfile profile = VelocityProfile::toSpeed(v0, a0, v_target, kAMax, kJMax);
+				checkLimits(profile, a0);
+				CHECK_NEAR(profile.finalSpeed(), v_target, 1e-6);
+				double s, v, a;
+				profile.sample(profile.duration() + 0.5, s, v, a);
+				CHECK_NEAR(v, v_target, 1e-6);
+				CHECK_NEAR(a, 0.0, 1e-9);
+				CHECK_NEAR(s, profile.distance() + 0.5 * v_target, 1e-6);
+			}
+		}
+	}
+}
+
+static void testBatchSampling()
+{
+	VelocityProfile profile = VelocityProfile::toSpeed(12.0, 2.0, 22.0, kAMax, kJMax);
+	// starting before 0 and running past the end
+	int n = 300;
+	double t0 = -0.1;
+	double dt = 0.02;
+	vector<double> s(n), v(n), a(n);
+	profile.sample(t0, dt, n, s.data(), v.data(), a.data());
+	for (int i = 5; i < n; i++)
+	{
+		double s_i, v_i, a_i;
+		profile.sample(t0 + i * dt, s_i, v_i, a_i);
+		CHECK_NEAR(s[i], s_i, 1e-9);
+		CHECK_NEAR(v[i], v_i, 1e-9);
+		CHECK_NEAR(a[i], a_i, 1e-9);
+	}
+	for (int i = 0; i < 5; i++)
+	{
+		CHECK(s[i] == 0.0 && v[i] == 12.0 && a[i] == 2.0);
+	}
+}
+
+static void testToStop()
+{
+	for (double v0 : {5.0, 15.0, 22.0})
+	{
+		for (double a0 : {-2.0, 0.0, 2.0})
+		{
+			// far enough: cruise, then stop exactly at s_stop
+			double s_stop = 150.0;
+			VelocityProfile profile = VelocityProfile::toStop(v0, a0, s_stop, kAMax, kJMax);
+			checkLimits(profile, a0);
+			CHECK_NEAR(profile.finalSpeed(), 0.0, 1e-6);
+			CHECK_NEAR(profile.distance(), s_stop, 1e-6);
+
+			// too short to stop in: brake right away, which ends where
+			// braking to standstill ends and never rolls backwards
+			VelocityProfile brake = VelocityProfile::toSpeed(v0, a0, 0.0, kAMax, kJMax);
+			VelocityProfile short_stop = VelocityProfile::toStop(v0, a0, 0.5 * brake.distance(), kAMax, kJMax);
+			checkLimits(short_stop, a0);
+			CHECK_NEAR(short_stop.finalSpeed(), 0.0, 1e-6);
+			CHECK_NEAR(short_stop.distance(), brake.distance(), 1e-9);
+			for (double t = 0.0; t < short_stop.duration() + 1.0; t += 0.01)
+			{
+				double s, v, a;
+				short_stop.sample(t, s, v, a);
+				CHECK(v >= -1e-9);
+				CHECK(s <= brake.distance() + 1e-9);
+			}
+		}
+	}
+}
+
+int main()
+{
+	testToSpeed();
+	testBatchSampling();
+	testToStop();
+	return testResult();
+}